@@ -0,0 +1,318 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "BinaryFilter.h"
+
+//Qt
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QCryptographicHash>
+
+//SIMD
+#if defined(_M_IX86) || defined(_M_X64)
+#define HAVE_SSE2_KERNEL 1
+#include <intrin.h>
+#include <emmintrin.h>
+#endif
+
+//Forward declarations
+static bool detectSSE2(void);
+static __forceinline bool isControl(const uchar c);
+static void countControls(const uchar *bytes, const int from, const int len, int &nulls, int &controls);
+static __forceinline int countBits(unsigned long mask);
+static QString formatSize(const qint64 size);
+
+//Const
+static const bool g_useSSE2 = detectSSE2();
+static const int EXCERPT_SIZE = 32;
+static const int CONTROL_RATIO = 16;
+
+//Helper
+#define SAFE_DEL(X) do { if(X) { delete (X); X = NULL; } } while (0)
+
+/*
+ * Constructor
+ */
+CBinaryFilter::CBinaryFilter(const Mode mode)
+:
+	m_mode(mode),
+	m_sideFile(NULL)
+{
+	for(int i = 0; i < MAX_CHANNELS; i++)
+	{
+		m_regions[i].size = 0;
+		m_regions[i].sideOffset = -1;
+		m_regions[i].hash = NULL;
+	}
+}
+
+/*
+ * Destructor
+ */
+CBinaryFilter::~CBinaryFilter(void)
+{
+	for(int i = 0; i < MAX_CHANNELS; i++)
+	{
+		SAFE_DEL(m_regions[i].hash);
+	}
+
+	if(m_sideFile)
+	{
+		m_sideFile->close();
+		SAFE_DEL(m_sideFile);
+	}
+}
+
+/*
+ * Check a block of data for NUL bytes and for a high density of control characters (other than whitespace and ESC)
+ */
+bool CBinaryFilter::isBinary(const char *data, const int len)
+{
+	const uchar *bytes = reinterpret_cast<const uchar*>(data);
+	int nulls = 0, controls = 0, i = 0;
+
+#ifdef HAVE_SSE2_KERNEL
+	if(g_useSSE2)
+	{
+		const __m128i valueMaxControl = _mm_set1_epi8(0x1F);
+		const __m128i valueLowerSpace = _mm_set1_epi8(0x08);
+		const __m128i valueSpaceRange = _mm_set1_epi8(0x05);
+		const __m128i valueEscape = _mm_set1_epi8(0x1B);
+		const __m128i zero = _mm_setzero_si128();
+
+		//Process 16 bytes at a time, control characters are 0x00-0x1F except for 0x08-0x0D and 0x1B
+		while(i + 16 <= len)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+			const __m128i isLow = _mm_cmpeq_epi8(_mm_min_epu8(v, valueMaxControl), v);
+			const __m128i offset = _mm_sub_epi8(v, valueLowerSpace);
+			const __m128i isSpace = _mm_cmpeq_epi8(_mm_min_epu8(offset, valueSpaceRange), offset);
+			const __m128i isAllowed = _mm_or_si128(isSpace, _mm_cmpeq_epi8(v, valueEscape));
+			nulls += countBits(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)));
+			controls += countBits(_mm_movemask_epi8(_mm_andnot_si128(isAllowed, isLow)));
+			i += 16;
+		}
+	}
+#endif //HAVE_SSE2_KERNEL
+
+	countControls(bytes, i, len, nulls, controls);
+
+	return (nulls > 0) || ((controls > 1) && ((controls * CONTROL_RATIO) >= len));
+}
+
+/*
+ * Find the lines of a binary block that contain NUL bytes or control characters, the other lines are text
+ */
+void CBinaryFilter::binaryRange(const char *data, const int len, int &begin, int &end)
+{
+	const uchar *bytes = reinterpret_cast<const uchar*>(data);
+	begin = 0;
+	end = len;
+
+	while((begin < len) && (!isControl(bytes[begin]))) begin++;
+	while((end > begin) && (!isControl(bytes[end - 1]))) end--;
+
+	if(begin >= end)
+	{
+		begin = end = len;
+		return;
+	}
+
+	//Extend to the beginning of the first line and to the end of the last line
+	while((begin > 0) && (bytes[begin - 1] != '\n')) begin--;
+	while((end < len) && (bytes[end - 1] != '\n')) end++;
+}
+
+/*
+ * Add data to the binary region of the channel (a new region is started, if none is active)
+ */
+void CBinaryFilter::append(const char *data, const int len, const int channel)
+{
+	region_t &region = m_regions[channelIndex(channel)];
+
+	if(region.size < 1)
+	{
+		if(!region.hash)
+		{
+			region.hash = new QCryptographicHash(QCryptographicHash::Sha1);
+		}
+		region.hash->reset();
+		region.excerpt.clear();
+		region.sideOffset = -1;
+	}
+
+	region.hash->addData(data, len);
+
+	if((m_mode != BINARY_SUMMARY) && (region.excerpt.size() < EXCERPT_SIZE))
+	{
+		region.excerpt.append(data, qMin(len, EXCERPT_SIZE - region.excerpt.size()));
+	}
+
+	//The data is written straight from the input buffer
+	if(m_sideFile)
+	{
+		if(region.sideOffset < 0)
+		{
+			region.sideOffset = m_sideFile->size();
+		}
+		m_sideFile->write(data, len);
+	}
+
+	region.size += len;
+}
+
+/*
+ * End the binary region of the channel and describe it
+ */
+QString CBinaryFilter::takeSummary(const int channel)
+{
+	region_t &region = m_regions[channelIndex(channel)];
+
+	QString summary = QString("[binary %1, sha1=%2").arg(formatSize(region.size), QString::fromLatin1(region.hash->result().toHex()));
+
+	switch(m_mode)
+	{
+	case BINARY_HEX:
+		summary.append(QString(", hex=%1").arg(QString::fromLatin1(region.excerpt.toHex())));
+		break;
+	case BINARY_BASE64:
+		summary.append(QString(", base64=%1").arg(QString::fromLatin1(region.excerpt.toBase64())));
+		break;
+	default:
+		break;
+	}
+
+	if(region.sideOffset >= 0)
+	{
+		m_sideFile->flush();
+		summary.append(QString(", saved to %1 at offset %2").arg(QDir::toNativeSeparators(m_sideFile->fileName()), QString::number(region.sideOffset)));
+	}
+
+	summary.append(QChar(']'));
+
+	region.size = 0;
+	return summary;
+}
+
+/*
+ * Write all binary regions to a side file (appends, if the file exists)
+ */
+bool CBinaryFilter::setSideFile(const QString &fileName)
+{
+	if(m_sideFile)
+	{
+		m_sideFile->close();
+		SAFE_DEL(m_sideFile);
+	}
+
+	if(fileName.isEmpty())
+	{
+		return true;
+	}
+
+	m_sideFile = new QFile(QFileInfo(fileName).absoluteFilePath());
+	if(!m_sideFile->open(QIODevice::WriteOnly | QIODevice::Append))
+	{
+		SAFE_DEL(m_sideFile);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Region index for the channel flag
+ */
+int CBinaryFilter::channelIndex(const int channel)
+{
+	int index = 0;
+	while((index < (MAX_CHANNELS - 1)) && (!(channel & (1 << index)))) index++;
+	return index;
+}
+
+// ===================================================
+// Misc Stuff
+// ===================================================
+
+/*
+ * Check whether SSE2 is available
+ */
+static bool detectSSE2(void)
+{
+#if defined(_M_X64)
+	return true;
+#elif defined(_M_IX86)
+	int info[4];
+	__cpuid(info, 1);
+	return ((info[3] & (1 << 26)) != 0);
+#else
+	return false;
+#endif
+}
+
+/*
+ * Control characters, except for whitespace (0x08-0x0D) and ESC (used by color codes)
+ */
+static __forceinline bool isControl(const uchar c)
+{
+	return (c < 0x20) && ((c < 0x08) || (c > 0x0D)) && (c != 0x1B);
+}
+
+/*
+ * Count NUL bytes and control characters (scalar implementation)
+ */
+static void countControls(const uchar *bytes, const int from, const int len, int &nulls, int &controls)
+{
+	for(int i = from; i < len; i++)
+	{
+		if(!bytes[i]) nulls++;
+		if(isControl(bytes[i])) controls++;
+	}
+}
+
+/*
+ * Number of bits set in the 16-Bit mask
+ */
+static __forceinline int countBits(unsigned long mask)
+{
+	mask = mask - ((mask >> 1) & 0x5555);
+	mask = (mask & 0x3333) + ((mask >> 2) & 0x3333);
+	mask = (mask + (mask >> 4)) & 0x0F0F;
+	return int((mask + (mask >> 8)) & 0x1F);
+}
+
+/*
+ * Human-readable size
+ */
+static QString formatSize(const qint64 size)
+{
+	if(size < 1024)
+	{
+		return QString("%1 bytes").arg(size);
+	}
+	if(size < (Q_INT64_C(1) << 20))
+	{
+		return QString().sprintf("%.1f KiB", double(size) / 1024.0);
+	}
+	return QString().sprintf("%.1f MiB", double(size) / 1048576.0);
+}
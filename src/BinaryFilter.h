@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+
+//Forward declaration
+class QFile;
+class QCryptographicHash;
+
+//Class CBinaryFilter
+//Detects non-text data and condenses each binary region of a channel into a single summary line
+class CBinaryFilter
+{
+public:
+	//Types
+	typedef enum
+	{
+		BINARY_SUMMARY = 0,
+		BINARY_HEX = 1,
+		BINARY_BASE64 = 2
+	}
+	Mode;
+
+	CBinaryFilter(const Mode mode);
+	~CBinaryFilter(void);
+
+	//Data processing
+	static bool isBinary(const char *data, const int len);
+	static void binaryRange(const char *data, const int len, int &begin, int &end);
+	void append(const char *data, const int len, const int channel);
+	bool isActive(const int channel) const { return m_regions[channelIndex(channel)].size > 0; }
+	QString takeSummary(const int channel);
+
+	//Setter methods
+	bool setSideFile(const QString &fileName);
+
+	//Const
+	static const int BLOCK_SIZE = 4096;
+
+private:
+	CBinaryFilter(const CBinaryFilter&);
+	CBinaryFilter &operator=(const CBinaryFilter&);
+
+	static const int MAX_CHANNELS = 8;
+
+	typedef struct
+	{
+		qint64 size;
+		qint64 sideOffset;
+		QCryptographicHash *hash;
+		QByteArray excerpt;
+	}
+	region_t;
+
+	static int channelIndex(const int channel);
+
+	const Mode m_mode;
+	region_t m_regions[MAX_CHANNELS];
+	QFile *m_sideFile;
+};
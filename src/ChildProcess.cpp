@@ -0,0 +1,681 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "ChildProcess.h"
+
+//Windows
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+//Qt
+#include <QStringList>
+#include <QTimer>
+
+//CRT
+#include <climits>
+
+//Internal
+#include "InputReader.h"
+
+//Const
+static const DWORD PIPE_BUFFER_SIZE = 65536;
+static const UINT KILL_EXIT_CODE = 0xF291;
+static const DWORD READER_TIMEOUT = 5000;
+static const DWORD DRAIN_TIMEOUT = 1000;
+static const int EXIT_POLL_INTERVAL = 10;
+static const DWORD_PTR ATTRIBUTE_PSEUDOCONSOLE = 0x00020016;
+static const DWORD CREATE_EXTENDED_STARTUPINFO = 0x00080000;
+static const int MAX_CURSOR_FORWARD = 1024;
+
+//Exit states
+static const int EXIT_NONE = 0;
+static const int EXIT_DRAIN = 1;
+static const int EXIT_READERS = 2;
+static const int EXIT_ABORTED = 3;
+
+//Terminal states
+static const int VT_TEXT = 0;
+static const int VT_ESCAPE = 1;
+static const int VT_CSI = 2;
+static const int VT_OSC = 3;
+static const int VT_OSC_ESCAPE = 4;
+
+//Pseudo console API (Windows 10 version 1809 or later)
+typedef HRESULT (WINAPI *FunCreatePseudoConsole)(COORD size, HANDLE hInput, HANDLE hOutput, DWORD dwFlags, void **phPC);
+typedef void (WINAPI *FunClosePseudoConsole)(void *hPC);
+typedef BOOL (WINAPI *FunInitializeProcThreadAttributeList)(void *lpAttributeList, DWORD dwAttributeCount, DWORD dwFlags, SIZE_T *lpSize);
+typedef BOOL (WINAPI *FunUpdateProcThreadAttribute)(void *lpAttributeList, DWORD dwFlags, DWORD_PTR Attribute, PVOID lpValue, SIZE_T cbSize, PVOID lpPreviousValue, SIZE_T *lpReturnSize);
+typedef void (WINAPI *FunDeleteProcThreadAttributeList)(void *lpAttributeList);
+
+//Extended startup info (not declared for Windows XP targets)
+typedef struct
+{
+	STARTUPINFOW StartupInfo;
+	void *lpAttributeList;
+}
+startup_info_ex_t;
+
+//Helper
+#define SAFE_DEL(X) do { if(X) { delete (X); X = NULL; } } while (0)
+#define SAFE_CLOSE(X) do { if(X) { CloseHandle(X); X = NULL; } } while (0)
+
+//Forward declarations
+static VOID CALLBACK exitCallback(PVOID param, BOOLEAN timedOut);
+static FARPROC kernelFunction(const char *name);
+static bool isPipeIdle(HANDLE pipe);
+static void stripTerminalSequences(QByteArray &data, int &state, int &param);
+
+/*
+ * Constructor
+ */
+CChildProcess::CChildProcess(void)
+:
+	m_processHandle(NULL),
+	m_waitHandle(NULL),
+	m_pipeStdinp(NULL),
+	m_pipeStdout(NULL),
+	m_pipeStderr(NULL),
+	m_processId(0),
+	m_pseudoConsole(NULL),
+	m_ptyColumns(0),
+	m_ptyRows(0),
+	m_vtState(VT_TEXT),
+	m_vtParam(0),
+	m_readerStdout(NULL),
+	m_readerStderr(NULL),
+	m_exitTimer(NULL),
+	m_exitState(EXIT_NONE),
+	m_exitTime(0),
+	m_drainIdle(false),
+	m_finished(false)
+{
+}
+
+/*
+ * Destructor
+ */
+CChildProcess::~CChildProcess(void)
+{
+	cleanUp();
+}
+
+/*
+ * Create the process, STDOUT and STDERR are redirected to our pipes (or to the pseudo console)
+ */
+bool CChildProcess::start(const QString &program, const QStringList &arguments)
+{
+	if(m_processHandle)
+	{
+		return false;
+	}
+
+	//The command-line buffer must be writable
+	QString commandLine = createCommandLine(program, arguments);
+	const bool created = (m_ptyColumns > 0) ? createWithPseudoConsole(commandLine) : createWithPipes(commandLine);
+
+	if(!created)
+	{
+		cleanUp();
+		return false;
+	}
+
+	m_finished = false;
+	m_exitState = EXIT_NONE;
+	m_vtState = VT_TEXT;
+	m_vtParam = 0;
+
+	//Start readers, notifications are forwarded to our thread (there is no STDERR on a pseudo console)
+	m_readerStdout = new CInputReader(m_pipeStdout);
+	connect(m_readerStdout, SIGNAL(dataAvailable(quint32)), this, SIGNAL(readyReadStdout()), Qt::QueuedConnection);
+	m_readerStdout->start();
+
+	if(m_pipeStderr)
+	{
+		m_readerStderr = new CInputReader(m_pipeStderr);
+		connect(m_readerStderr, SIGNAL(dataAvailable(quint32)), this, SIGNAL(readyReadStderr()), Qt::QueuedConnection);
+		m_readerStderr->start();
+	}
+
+	//Get notified when the process terminates
+	HANDLE waitHandle = NULL;
+	if(RegisterWaitForSingleObject(&waitHandle, m_processHandle, exitCallback, this, INFINITE, WT_EXECUTEONLYONCE))
+	{
+		m_waitHandle = waitHandle;
+	}
+
+	return true;
+}
+
+/*
+ * Run the child on a pseudo console of the given size (zero columns means pipes)
+ */
+void CChildProcess::setPseudoConsole(const int columns, const int rows)
+{
+	m_ptyColumns = qBound(0, columns, SHRT_MAX);
+	m_ptyRows = qBound(1, rows, SHRT_MAX);
+}
+
+/*
+ * Check whether the process is running (until the finished signal has been emitted)
+ */
+bool CChildProcess::isRunning(void) const
+{
+	return m_processHandle && (!m_finished);
+}
+
+/*
+ * Terminate the process
+ */
+void CChildProcess::kill(void)
+{
+	if(isRunning())
+	{
+		TerminateProcess(m_processHandle, KILL_EXIT_CODE);
+	}
+}
+
+/*
+ * Wait until the process has terminated and all output has been read
+ */
+bool CChildProcess::waitForFinished(void)
+{
+	if(!m_processHandle)
+	{
+		return false;
+	}
+
+	if(!m_finished)
+	{
+		WaitForSingleObject(m_processHandle, INFINITE);
+		handleExit();
+	}
+
+	while(!m_finished)
+	{
+		Sleep(EXIT_POLL_INTERVAL);
+		checkExit();
+	}
+
+	return true;
+}
+
+/*
+ * Read all data currently available from STDOUT
+ */
+size_t CChildProcess::readStdout(QByteArray &output)
+{
+	const size_t bytes = m_readerStdout ? m_readerStdout->readAllData(output) : 0;
+
+	//The pseudo console renders the output as a terminal stream
+	if((bytes > 0) && m_pseudoConsole)
+	{
+		stripTerminalSequences(output, m_vtState, m_vtParam);
+	}
+
+	return bytes;
+}
+
+/*
+ * Read all data currently available from STDERR
+ */
+size_t CChildProcess::readStderr(QByteArray &output)
+{
+	return m_readerStderr ? m_readerStderr->readAllData(output) : 0;
+}
+
+/*
+ * Process has terminated, the finished signal is emitted once the output has been read
+ */
+void CChildProcess::handleExit(void)
+{
+	if(m_finished || (m_exitState != EXIT_NONE) || (!m_processHandle))
+	{
+		return;
+	}
+
+	m_exitState = m_pseudoConsole ? EXIT_DRAIN : EXIT_READERS;
+	m_exitTime = GetTickCount();
+	m_drainIdle = false;
+
+	checkExit();
+}
+
+/*
+ * Advance the shutdown without blocking the event loop, re-scheduled until the readers have finished
+ */
+void CChildProcess::checkExit(void)
+{
+	if(m_finished || (m_exitState == EXIT_NONE))
+	{
+		return;
+	}
+
+	const DWORD elapsed = GetTickCount() - m_exitTime;
+
+	//The output pipe of the pseudo console is not closed, until the pseudo console is
+	//Closing the console discards what has not been read yet, so wait until the pipe has been idle for two checks
+	if(m_exitState == EXIT_DRAIN)
+	{
+		const bool idle = isPipeIdle(m_pipeStdout);
+		if((!(idle && m_drainIdle)) && (elapsed <= DRAIN_TIMEOUT))
+		{
+			m_drainIdle = idle;
+			scheduleExitCheck();
+			return;
+		}
+		closePseudoConsole();
+		m_exitState = EXIT_READERS;
+		m_exitTime = GetTickCount();
+	}
+
+	//Wait until the pipes have reached their end (might be held open by sub-processes)
+	CInputReader *readers[2] = { m_readerStdout, m_readerStderr };
+	bool running = false;
+	for(size_t i = 0; i < 2; i++)
+	{
+		running = running || (readers[i] && readers[i]->isRunning());
+	}
+
+	if(running)
+	{
+		if((GetTickCount() - m_exitTime) > READER_TIMEOUT)
+		{
+			for(size_t i = 0; i < 2; i++)
+			{
+				if(readers[i] && readers[i]->isRunning())
+				{
+					if(m_exitState == EXIT_ABORTED)
+					{
+						readers[i]->terminate();
+						readers[i]->wait();
+					}
+					else
+					{
+						readers[i]->abort();
+					}
+				}
+			}
+			m_exitState = EXIT_ABORTED;
+			m_exitTime = GetTickCount();
+		}
+		scheduleExitCheck();
+		return;
+	}
+
+	DWORD exitCode = 0;
+	if(!GetExitCodeProcess(m_processHandle, &exitCode))
+	{
+		exitCode = DWORD(-1);
+	}
+
+	m_finished = true;
+	emit finished(int(exitCode));
+}
+
+/*
+ * Check the progress of the shutdown again a little later
+ */
+void CChildProcess::scheduleExitCheck(void)
+{
+	if(!m_exitTimer)
+	{
+		m_exitTimer = new QTimer(this);
+		m_exitTimer->setSingleShot(true);
+		connect(m_exitTimer, SIGNAL(timeout()), this, SLOT(checkExit()));
+	}
+	if(!m_exitTimer->isActive())
+	{
+		m_exitTimer->start(EXIT_POLL_INTERVAL);
+	}
+}
+
+/*
+ * Release all resources
+ */
+void CChildProcess::cleanUp(void)
+{
+	if(m_waitHandle)
+	{
+		UnregisterWaitEx(m_waitHandle, INVALID_HANDLE_VALUE);
+		m_waitHandle = NULL;
+	}
+
+	m_exitState = EXIT_NONE;
+
+	if(m_processHandle && (!m_finished))
+	{
+		TerminateProcess(m_processHandle, KILL_EXIT_CODE);
+		WaitForSingleObject(m_processHandle, INFINITE);
+	}
+
+	closePseudoConsole();
+
+	CInputReader *readers[2] = { m_readerStdout, m_readerStderr };
+	for(size_t i = 0; i < 2; i++)
+	{
+		if(readers[i] && readers[i]->isRunning())
+		{
+			readers[i]->abort();
+			if(!readers[i]->wait(READER_TIMEOUT))
+			{
+				readers[i]->terminate();
+				readers[i]->wait();
+			}
+		}
+	}
+
+	SAFE_DEL(m_readerStdout);
+	SAFE_DEL(m_readerStderr);
+
+	SAFE_CLOSE(m_pipeStdinp);
+	SAFE_CLOSE(m_pipeStdout);
+	SAFE_CLOSE(m_pipeStderr);
+	SAFE_CLOSE(m_processHandle);
+}
+
+/*
+ * Create the process with STDOUT and STDERR redirected to our pipes
+ */
+bool CChildProcess::createWithPipes(QString &commandLine)
+{
+	SECURITY_ATTRIBUTES secAttr;
+	memset(&secAttr, 0, sizeof(SECURITY_ATTRIBUTES));
+	secAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
+	secAttr.bInheritHandle = TRUE;
+
+	//Create pipes, only the child's ends must be inheritable
+	HANDLE childStdinp = NULL, childStdout = NULL, childStderr = NULL;
+	bool pipesCreated = true;
+	pipesCreated = pipesCreated && CreatePipe(&childStdinp, &m_pipeStdinp, &secAttr, 0);
+	pipesCreated = pipesCreated && CreatePipe(&m_pipeStdout, &childStdout, &secAttr, PIPE_BUFFER_SIZE);
+	pipesCreated = pipesCreated && CreatePipe(&m_pipeStderr, &childStderr, &secAttr, PIPE_BUFFER_SIZE);
+	pipesCreated = pipesCreated && SetHandleInformation(m_pipeStdinp, HANDLE_FLAG_INHERIT, 0);
+	pipesCreated = pipesCreated && SetHandleInformation(m_pipeStdout, HANDLE_FLAG_INHERIT, 0);
+	pipesCreated = pipesCreated && SetHandleInformation(m_pipeStderr, HANDLE_FLAG_INHERIT, 0);
+
+	if(!pipesCreated)
+	{
+		m_errorString = QString().sprintf("Failed to create pipes (error code: 0x%08X)", GetLastError());
+		SAFE_CLOSE(childStdinp); SAFE_CLOSE(childStdout); SAFE_CLOSE(childStderr);
+		return false;
+	}
+
+	STARTUPINFOW startupInfo;
+	memset(&startupInfo, 0, sizeof(STARTUPINFOW));
+	startupInfo.cb = sizeof(STARTUPINFOW);
+	startupInfo.dwFlags = STARTF_USESTDHANDLES;
+	startupInfo.hStdInput = childStdinp;
+	startupInfo.hStdOutput = childStdout;
+	startupInfo.hStdError = childStderr;
+
+	PROCESS_INFORMATION processInfo;
+	memset(&processInfo, 0, sizeof(PROCESS_INFORMATION));
+
+	const BOOL created = CreateProcessW(NULL, reinterpret_cast<LPWSTR>(commandLine.data()), NULL, NULL, TRUE, 0, NULL, NULL, &startupInfo, &processInfo);
+	const DWORD error = GetLastError();
+
+	//The child's ends of the pipes are not needed by us
+	SAFE_CLOSE(childStdinp); SAFE_CLOSE(childStdout); SAFE_CLOSE(childStderr);
+
+	if(!created)
+	{
+		m_errorString = QString().sprintf("Failed to create process (error code: 0x%08X)", error);
+		return false;
+	}
+
+	CloseHandle(processInfo.hThread);
+	m_processHandle = processInfo.hProcess;
+	m_processId = processInfo.dwProcessId;
+	return true;
+}
+
+/*
+ * Create the process on a pseudo console, STDOUT and STDERR are merged into the console's output pipe
+ */
+bool CChildProcess::createWithPseudoConsole(QString &commandLine)
+{
+	static const FunCreatePseudoConsole createPseudoConsole = (FunCreatePseudoConsole) kernelFunction("CreatePseudoConsole");
+	static const FunInitializeProcThreadAttributeList initializeAttributes = (FunInitializeProcThreadAttributeList) kernelFunction("InitializeProcThreadAttributeList");
+	static const FunUpdateProcThreadAttribute updateAttribute = (FunUpdateProcThreadAttribute) kernelFunction("UpdateProcThreadAttribute");
+	static const FunDeleteProcThreadAttributeList deleteAttributes = (FunDeleteProcThreadAttributeList) kernelFunction("DeleteProcThreadAttributeList");
+
+	if(!(createPseudoConsole && initializeAttributes && updateAttribute && deleteAttributes))
+	{
+		m_errorString = QString("Pseudo consoles are not supported (requires Windows 10 version 1809 or later)");
+		return false;
+	}
+
+	//The pseudo console owns the child's ends of the pipes, nothing is inherited
+	HANDLE consoleInput = NULL, consoleOutput = NULL;
+	bool pipesCreated = true;
+	pipesCreated = pipesCreated && CreatePipe(&consoleInput, &m_pipeStdinp, NULL, 0);
+	pipesCreated = pipesCreated && CreatePipe(&m_pipeStdout, &consoleOutput, NULL, PIPE_BUFFER_SIZE);
+
+	if(!pipesCreated)
+	{
+		m_errorString = QString().sprintf("Failed to create pipes (error code: 0x%08X)", GetLastError());
+		SAFE_CLOSE(consoleInput); SAFE_CLOSE(consoleOutput);
+		return false;
+	}
+
+	//A wide console keeps long lines from being wrapped
+	COORD size;
+	size.X = SHORT(m_ptyColumns);
+	size.Y = SHORT(m_ptyRows);
+
+	const HRESULT result = createPseudoConsole(size, consoleInput, consoleOutput, 0, &m_pseudoConsole);
+	SAFE_CLOSE(consoleInput); SAFE_CLOSE(consoleOutput);
+
+	if(FAILED(result))
+	{
+		m_errorString = QString().sprintf("Failed to create pseudo console (error code: 0x%08X)", result);
+		m_pseudoConsole = NULL;
+		return false;
+	}
+
+	SIZE_T attributeSize = 0;
+	initializeAttributes(NULL, 1, 0, &attributeSize);
+	QByteArray attributeList(int(attributeSize), '\0');
+
+	if(!(initializeAttributes(attributeList.data(), 1, 0, &attributeSize) && updateAttribute(attributeList.data(), 0, ATTRIBUTE_PSEUDOCONSOLE, m_pseudoConsole, sizeof(void*), NULL, NULL)))
+	{
+		m_errorString = QString().sprintf("Failed to attach pseudo console (error code: 0x%08X)", GetLastError());
+		return false;
+	}
+
+	startup_info_ex_t startupInfo;
+	memset(&startupInfo, 0, sizeof(startup_info_ex_t));
+	startupInfo.StartupInfo.cb = sizeof(startup_info_ex_t);
+	startupInfo.lpAttributeList = attributeList.data();
+
+	PROCESS_INFORMATION processInfo;
+	memset(&processInfo, 0, sizeof(PROCESS_INFORMATION));
+
+	const BOOL created = CreateProcessW(NULL, reinterpret_cast<LPWSTR>(commandLine.data()), NULL, NULL, FALSE, CREATE_EXTENDED_STARTUPINFO, NULL, NULL, &startupInfo.StartupInfo, &processInfo);
+	const DWORD error = GetLastError();
+	deleteAttributes(attributeList.data());
+
+	if(!created)
+	{
+		m_errorString = QString().sprintf("Failed to create process (error code: 0x%08X)", error);
+		return false;
+	}
+
+	CloseHandle(processInfo.hThread);
+	m_processHandle = processInfo.hProcess;
+	m_processId = processInfo.dwProcessId;
+	return true;
+}
+
+/*
+ * Close the pseudo console, which lets the output pipe reach its end
+ */
+void CChildProcess::closePseudoConsole(void)
+{
+	static const FunClosePseudoConsole closeConsole = (FunClosePseudoConsole) kernelFunction("ClosePseudoConsole");
+
+	if(m_pseudoConsole && closeConsole)
+	{
+		closeConsole(m_pseudoConsole);
+	}
+
+	m_pseudoConsole = NULL;
+}
+
+/*
+ * Build the command-line (same quoting rules as QProcess)
+ */
+QString CChildProcess::createCommandLine(const QString &program, const QStringList &arguments)
+{
+	QString programName = QString(program).replace(QChar('/'), QChar('\\'));
+	if((!programName.startsWith(QChar('"'))) && (!programName.endsWith(QChar('"'))) && programName.contains(QChar(' ')))
+	{
+		programName = QString("\"%1\"").arg(programName);
+	}
+
+	QString commandLine = programName;
+
+	for(QStringList::ConstIterator iter = arguments.constBegin(); iter != arguments.constEnd(); iter++)
+	{
+		//Quotes are escaped and their preceding backslashes are doubled
+		QString argument;
+		int backslashes = 0;
+		for(int i = 0; i < iter->length(); i++)
+		{
+			const QChar c = iter->at(i);
+			if(c == QChar('"'))
+			{
+				argument.append(QString(backslashes + 1, QChar('\\')));
+			}
+			backslashes = (c == QChar('\\')) ? (backslashes + 1) : 0;
+			argument.append(c);
+		}
+
+		//Trailing backslashes must not escape the closing quote
+		if(argument.isEmpty() || argument.contains(QChar(' ')) || argument.contains(QChar('\t')))
+		{
+			int pos = argument.length();
+			while((pos > 0) && (argument.at(pos - 1) == QChar('\\'))) pos--;
+			argument.insert(pos, QChar('"'));
+			argument.prepend(QChar('"'));
+		}
+
+		commandLine.append(QChar(' ')).append(argument);
+	}
+
+	return commandLine;
+}
+
+// ===================================================
+// Misc Stuff
+// ===================================================
+
+/*
+ * Called on a thread pool thread, when the process has terminated
+ */
+static VOID CALLBACK exitCallback(PVOID param, BOOLEAN timedOut)
+{
+	if(!timedOut)
+	{
+		QMetaObject::invokeMethod(static_cast<QObject*>(param), "handleExit", Qt::QueuedConnection);
+	}
+}
+
+/*
+ * Look up a function of Kernel32.dll (NULL, if not available)
+ */
+static FARPROC kernelFunction(const char *name)
+{
+	if(HMODULE krnl32 = GetModuleHandleA("Kernel32.dll"))
+	{
+		return GetProcAddress(krnl32, name);
+	}
+	return NULL;
+}
+
+/*
+ * Check whether all data written to the pipe has been read (a broken pipe is idle too)
+ */
+static bool isPipeIdle(HANDLE pipe)
+{
+	DWORD bytesAvailable = 0;
+	if(!PeekNamedPipe(pipe, NULL, 0, NULL, &bytesAvailable, NULL))
+	{
+		return true;
+	}
+	return (bytesAvailable < 1);
+}
+
+/*
+ * Remove the escape sequences of the terminal stream (cursor movements to the right are turned into spaces)
+ * Cursor positioning starts a new row of the terminal, so it is turned into a line break
+ */
+static void stripTerminalSequences(QByteArray &data, int &state, int &param)
+{
+	if((state == VT_TEXT) && (!data.contains('\x1B')))
+	{
+		return;
+	}
+
+	QByteArray text;
+	text.reserve(data.size());
+
+	for(int i = 0; i < data.size(); i++)
+	{
+		const char c = data.at(i);
+		switch(state)
+		{
+		case VT_TEXT:
+			if(c == '\x1B') state = VT_ESCAPE;
+			else text.append(c);
+			break;
+		case VT_ESCAPE:
+			if(c == '[') { state = VT_CSI; param = 0; }
+			else if(c == ']') state = VT_OSC;
+			else if((c < 0x20) || (c > 0x2F)) state = VT_TEXT;
+			break;
+		case VT_CSI:
+			if((c >= '0') && (c <= '9'))
+			{
+				param = qMin((param * 10) + (c - '0'), MAX_CURSOR_FORWARD);
+			}
+			else if((c >= 0x40) && (c <= 0x7E))
+			{
+				if(c == 'C') text.append(QByteArray(qMax(param, 1), ' '));
+				else if((c == 'H') || (c == 'f')) text.append('\n');
+				state = VT_TEXT;
+			}
+			break;
+		case VT_OSC:
+			if(c == '\x07') state = VT_TEXT;
+			else if(c == '\x1B') state = VT_OSC_ESCAPE;
+			break;
+		case VT_OSC_ESCAPE:
+			state = (c == '\\') ? VT_TEXT : VT_OSC;
+			break;
+		default:
+			throw "Bad selection!";
+		}
+	}
+
+	data = text;
+}
@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QObject>
+
+//Forward declaration
+class QStringList;
+class QTimer;
+class CInputReader;
+
+//Class CChildProcess
+//Runs the child process with its own pipes, output is drained by dedicated reader threads
+//Optionally the child runs on a pseudo console, so that it sees a terminal and does not buffer its output
+class CChildProcess : public QObject
+{
+	Q_OBJECT
+
+public:
+	CChildProcess(void);
+	~CChildProcess(void);
+
+	bool start(const QString &program, const QStringList &arguments);
+	bool isRunning(void) const;
+	void kill(void);
+	bool waitForFinished(void);
+
+	size_t readStdout(QByteArray &output);
+	size_t readStderr(QByteArray &output);
+
+	//Setter methods
+	void setPseudoConsole(const int columns, const int rows);
+
+	//Getter methods
+	void *processHandle(void) const { return m_processHandle; }
+	quint32 processId(void) const { return m_processId; }
+	const QString &errorString(void) const { return m_errorString; }
+
+signals:
+	void readyReadStdout(void);
+	void readyReadStderr(void);
+	void finished(int exitCode);
+
+private slots:
+	void handleExit(void);
+	void checkExit(void);
+
+private:
+	void scheduleExitCheck(void);
+	void cleanUp(void);
+	bool createWithPipes(QString &commandLine);
+	bool createWithPseudoConsole(QString &commandLine);
+	void closePseudoConsole(void);
+	static QString createCommandLine(const QString &program, const QStringList &arguments);
+
+	void *m_processHandle;
+	void *m_waitHandle;
+	void *m_pipeStdinp;
+	void *m_pipeStdout;
+	void *m_pipeStderr;
+	quint32 m_processId;
+
+	void *m_pseudoConsole;
+	int m_ptyColumns;
+	int m_ptyRows;
+	int m_vtState;
+	int m_vtParam;
+
+	CInputReader *m_readerStdout;
+	CInputReader *m_readerStderr;
+
+	QTimer *m_exitTimer;
+	int m_exitState;
+	quint32 m_exitTime;
+	bool m_drainIdle;
+
+	bool m_finished;
+	QString m_errorString;
+};
@@ -0,0 +1,359 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "ConfigFile.h"
+
+//Qt
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QRegExp>
+
+//Const
+static const int SETTLE_TIME = 500;
+
+//Forward declarations
+static bool isEnabled(const QString &value);
+static bool isDisabled(const QString &value);
+static QStringList splitArguments(const QString &text);
+
+//Helper
+#define SAFE_DEL(X) do { if(X) { delete (X); X = NULL; } } while (0)
+
+/*
+ * Constructor
+ */
+CConfigFile::CConfigFile(const QString &fileName)
+:
+	m_fileName(QFileInfo(fileName).absoluteFilePath()),
+	m_watcher(NULL),
+	m_settleTimer(NULL)
+{
+}
+
+/*
+ * Destructor
+ */
+CConfigFile::~CConfigFile(void)
+{
+	SAFE_DEL(m_watcher);
+	SAFE_DEL(m_settleTimer);
+}
+
+/*
+ * Read the file, each line is "key = value" ([sections] are for grouping only, comments start with ';' or '#')
+ */
+bool CConfigFile::load(void)
+{
+	QFile file(m_fileName);
+	if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		return false;
+	}
+
+	QTextStream stream(&file);
+	stream.setCodec("UTF-8");
+
+	QList<QPair<QString, QString> > entries;
+	while(!stream.atEnd())
+	{
+		const QString line = stream.readLine().trimmed();
+		if(line.isEmpty() || line.startsWith(';') || line.startsWith('#') || (line.startsWith('[') && line.endsWith(']')))
+		{
+			continue;
+		}
+
+		const int separator = line.indexOf('=');
+		const QString key = ((separator < 0) ? line : line.left(separator)).trimmed().toLower();
+		const QString value = (separator < 0) ? QString() : line.mid(separator + 1).trimmed();
+		if(key.isEmpty())
+		{
+			return false;
+		}
+
+		entries << qMakePair(key, value);
+	}
+
+	m_entries = entries;
+	return true;
+}
+
+/*
+ * Start watching the file for changes
+ */
+bool CConfigFile::watch(void)
+{
+	if(!m_watcher)
+	{
+		m_watcher = new QFileSystemWatcher();
+		connect(m_watcher, SIGNAL(fileChanged(QString)), this, SLOT(fileChanged(QString)));
+
+		//Editors write files in several steps, so wait until the file has settled
+		m_settleTimer = new QTimer();
+		m_settleTimer->setSingleShot(true);
+		m_settleTimer->setInterval(SETTLE_TIME);
+		connect(m_settleTimer, SIGNAL(timeout()), this, SIGNAL(changed()));
+	}
+
+	if(!m_watcher->files().contains(m_fileName))
+	{
+		m_watcher->addPath(m_fileName);
+	}
+
+	return m_watcher->files().contains(m_fileName);
+}
+
+/*
+ * Command-line equivalent of all the options (except for the input)
+ */
+QStringList CConfigFile::options(void) const
+{
+	QStringList options;
+
+	for(QList<QPair<QString, QString> >::ConstIterator iter = m_entries.constBegin(); iter != m_entries.constEnd(); iter++)
+	{
+		const QString &key = iter->first, &value = iter->second;
+
+		if((!key.compare("program")) || (!key.compare("arguments")) || (!key.compare("config")) || isDisabled(value))
+		{
+			continue;
+		}
+
+		options << QString("--%1").arg(key);
+
+		if((!key.compare("sink")) || (!key.compare("extract")))
+		{
+			//Two arguments, the first one ends at the first space
+			const int separator = value.indexOf(QRegExp("\\s"));
+			options << value.left(separator).trimmed();
+			options << ((separator < 0) ? QString() : value.mid(separator + 1).trimmed());
+			if(!key.compare("sink"))
+			{
+				options.last() = resolvePath(options.last());
+			}
+		}
+		else if((!key.compare("logfile")) || (!key.compare("binary-file")) || (!key.compare("trace")))
+		{
+			options << resolvePath(value);
+		}
+		else if(!isEnabled(value))
+		{
+			options << value;
+		}
+	}
+
+	return options;
+}
+
+/*
+ * Program and its arguments, or the input marker (empty, if not specified)
+ */
+QStringList CConfigFile::input(void) const
+{
+	QString program;
+	QStringList arguments;
+
+	for(QList<QPair<QString, QString> >::ConstIterator iter = m_entries.constBegin(); iter != m_entries.constEnd(); iter++)
+	{
+		if(!iter->first.compare("program"))
+		{
+			program = iter->second;
+		}
+		else if(!iter->first.compare("arguments"))
+		{
+			arguments = splitArguments(iter->second);
+		}
+	}
+
+	return program.isEmpty() ? QStringList() : (QStringList() << program << arguments);
+}
+
+/*
+ * Filter and format options from the command-line, they take precedence over the file whenever it is re-applied
+ */
+void CConfigFile::setOverrides(const QStringList &arguments)
+{
+	m_overrides.clear();
+
+	for(int i = 0; i < arguments.count(); i++)
+	{
+		if(!arguments.at(i).startsWith("--"))
+		{
+			continue;
+		}
+
+		const QString key = arguments.at(i).mid(2).toLower();
+		if((!key.compare("regexp-keep")) || (!key.compare("regexp-skip")))
+		{
+			if((i + 1) < arguments.count())
+			{
+				m_overrides << qMakePair(key, arguments.at(++i));
+			}
+		}
+		else if((!key.compare("plain-output")) || (!key.compare("html-output")) || (!key.compare("json-output")) || (!key.compare("no-simplify")) || (!key.compare("precise-time")))
+		{
+			m_overrides << qMakePair(key, QString());
+		}
+	}
+}
+
+/*
+ * Apply the filter and format options of the file, then the command-line options on top
+ * Options that are set in neither place get their default value, just like on startup
+ */
+bool CConfigFile::applyTo(CLogFormatter &formatter) const
+{
+	CLogFormatter::Format format = CLogFormatter::LOG_FORMAT_VERBOSE;
+	bool simplify = true, preciseTime = false;
+	QString regExpKeep, regExpSkip;
+
+	const QList<QPair<QString, QString> > entries = m_entries + m_overrides;
+	for(QList<QPair<QString, QString> >::ConstIterator iter = entries.constBegin(); iter != entries.constEnd(); iter++)
+	{
+		const QString &key = iter->first, &value = iter->second;
+
+		if(!key.compare("plain-output"))
+		{
+			if(isEnabled(value)) format = CLogFormatter::LOG_FORMAT_PLAIN;
+		}
+		else if(!key.compare("html-output"))
+		{
+			if(isEnabled(value)) format = CLogFormatter::LOG_FORMAT_HTML;
+		}
+		else if(!key.compare("json-output"))
+		{
+			if(isEnabled(value)) format = CLogFormatter::LOG_FORMAT_JSON;
+		}
+		else if(!key.compare("no-simplify"))
+		{
+			simplify = !isEnabled(value);
+		}
+		else if(!key.compare("precise-time"))
+		{
+			preciseTime = isEnabled(value);
+		}
+		else if(!key.compare("regexp-keep"))
+		{
+			regExpKeep = value;
+		}
+		else if(!key.compare("regexp-skip"))
+		{
+			regExpSkip = value;
+		}
+	}
+
+	if((!QRegExp(regExpKeep).isValid()) || (!QRegExp(regExpSkip).isValid()))
+	{
+		return false;
+	}
+
+	formatter.setFormat(format);
+	formatter.setSimplify(simplify);
+	formatter.setPreciseTime(preciseTime);
+	formatter.setFilter(regExpKeep, regExpSkip);
+	return true;
+}
+
+/*
+ * The file has been modified (or replaced)
+ */
+void CConfigFile::fileChanged(const QString &path)
+{
+	Q_UNUSED(path);
+
+	//Files that are replaced, rather than modified, drop out of the watch list
+	if(QFileInfo(m_fileName).exists() && (!m_watcher->files().contains(m_fileName)))
+	{
+		m_watcher->addPath(m_fileName);
+	}
+
+	m_settleTimer->start();
+}
+
+/*
+ * Relative paths are relative to the directory of the config file
+ */
+QString CConfigFile::resolvePath(const QString &path) const
+{
+	return path.isEmpty() ? path : QFileInfo(QFileInfo(m_fileName).absoluteDir(), path).absoluteFilePath();
+}
+
+// ===================================================
+// Misc Stuff
+// ===================================================
+
+/*
+ * Flag options are enabled by an empty value or by "true", "yes" and "on"
+ */
+static bool isEnabled(const QString &value)
+{
+	return value.isEmpty() || (!value.compare("true", Qt::CaseInsensitive)) || (!value.compare("yes", Qt::CaseInsensitive)) || (!value.compare("on", Qt::CaseInsensitive));
+}
+
+/*
+ * Options are skipped, if their value is "false", "no" or "off"
+ */
+static bool isDisabled(const QString &value)
+{
+	return (!value.compare("false", Qt::CaseInsensitive)) || (!value.compare("no", Qt::CaseInsensitive)) || (!value.compare("off", Qt::CaseInsensitive));
+}
+
+/*
+ * Split at spaces, except for spaces in double quotes
+ */
+static QStringList splitArguments(const QString &text)
+{
+	QStringList arguments;
+	QString current;
+	bool quoted = false, pending = false;
+
+	for(int i = 0; i < text.length(); i++)
+	{
+		const QChar c = text.at(i);
+		if(c == QChar('"'))
+		{
+			quoted = !quoted;
+			pending = true;
+		}
+		else if(c.isSpace() && (!quoted))
+		{
+			if(pending) arguments << current;
+			current.clear();
+			pending = false;
+		}
+		else
+		{
+			current.append(c);
+			pending = true;
+		}
+	}
+
+	if(pending)
+	{
+		arguments << current;
+	}
+
+	return arguments;
+}
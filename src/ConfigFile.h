@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+#include <QList>
+#include <QPair>
+
+//Internal
+#include "LogFormatter.h"
+
+//Forward declaration
+class QFileSystemWatcher;
+class QTimer;
+
+//Class CConfigFile
+//Options in a "key = value" file, the filter and format options can be re-applied whenever the file changes
+class CConfigFile : public QObject
+{
+	Q_OBJECT
+
+public:
+	CConfigFile(const QString &fileName);
+	~CConfigFile(void);
+
+	bool load(void);
+	bool watch(void);
+	void setOverrides(const QStringList &arguments);
+
+	//Getter methods
+	QStringList options(void) const;
+	QStringList input(void) const;
+	bool applyTo(CLogFormatter &formatter) const;
+	const QString &fileName(void) const { return m_fileName; }
+
+signals:
+	void changed(void);
+
+private slots:
+	void fileChanged(const QString &path);
+
+private:
+	QString resolvePath(const QString &path) const;
+
+	const QString m_fileName;
+	QList<QPair<QString, QString> > m_entries;
+	QList<QPair<QString, QString> > m_overrides;
+
+	QFileSystemWatcher *m_watcher;
+	QTimer *m_settleTimer;
+};
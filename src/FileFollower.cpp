@@ -0,0 +1,228 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "FileFollower.h"
+
+//Windows
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+//Qt
+#include <QMutex>
+#include <QMutexLocker>
+#include <QFileInfo>
+#include <QDir>
+#include <QElapsedTimer>
+
+//CRT
+#include <cstring>
+
+//Const
+static const int READ_SIZE = 1048576;
+static const DWORD POLL_INTERVAL = 1000;
+static const qint64 MAX_NOTIFY_DELAY = 100;
+
+/*
+ * Constructor
+ */
+CFileFollower::CFileFollower(const QString &fileName)
+:
+	CInputReader(INVALID_HANDLE_VALUE),
+	m_fileName(QDir::toNativeSeparators(QFileInfo(fileName).absoluteFilePath()))
+{
+	m_abortEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+}
+
+/*
+ * Destructor
+ */
+CFileFollower::~CFileFollower(void)
+{
+	if(m_abortEvent)
+	{
+		CloseHandle(m_abortEvent);
+	}
+}
+
+/*
+ * Abort Thread (also wakes up the thread, if it is waiting for changes)
+ */
+void CFileFollower::abort(void)
+{
+	CInputReader::abort();
+	if(m_abortEvent)
+	{
+		SetEvent(m_abortEvent);
+	}
+}
+
+/*
+ * Thread entry point
+ */
+void CFileFollower::run(void)
+{
+	HANDLE file = openFile();
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		emit followEvent(QString("Failed to open the followed file: %1").arg(m_fileName));
+		return;
+	}
+
+	//Only data that is appended from now on will be read, like "tail -f" does
+	LARGE_INTEGER fileSize;
+	qint64 offset = GetFileSizeEx(file, &fileSize) ? fileSize.QuadPart : 0;
+
+	//Changes in the directory wake us up, the timeout catches size changes that NTFS reports lazily
+	const QString directory = QDir::toNativeSeparators(QFileInfo(m_fileName).absolutePath());
+	HANDLE notify = FindFirstChangeNotificationW(reinterpret_cast<const wchar_t*>(directory.utf16()), FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+
+	QByteArray buffer(READ_SIZE, '\0');
+
+	//Main processing loop
+	while(!m_aborted)
+	{
+		offset = readNewData(file, offset, buffer);
+
+		//File has been truncated, so continue from the beginning
+		if(GetFileSizeEx(file, &fileSize) && (fileSize.QuadPart < offset))
+		{
+			emit followEvent("Followed file has been truncated, continue reading from the beginning");
+			offset = 0;
+			continue;
+		}
+
+		//File has been rotated, all data of the old file has been read at this point
+		if(isReplaced(file))
+		{
+			HANDLE newFile = openFile();
+			if(newFile != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(file);
+				file = newFile;
+				offset = 0;
+				emit followEvent("Followed file has been rotated, continue reading from the new file");
+				continue;
+			}
+		}
+
+		//Sleep until something changes (or we are aborted)
+		HANDLE waitHandles[2] = { m_abortEvent, notify };
+		const DWORD waitCount = (notify != INVALID_HANDLE_VALUE) ? 2 : 1;
+		if(WaitForMultipleObjects(waitCount, waitHandles, FALSE, POLL_INTERVAL) == (WAIT_OBJECT_0 + 1))
+		{
+			FindNextChangeNotification(notify);
+		}
+	}
+
+	if(notify != INVALID_HANDLE_VALUE)
+	{
+		FindCloseChangeNotification(notify);
+	}
+	CloseHandle(file);
+}
+
+/*
+ * Open the followed file (renaming and deleting the file must still be possible)
+ */
+void *CFileFollower::openFile(void) const
+{
+	return CreateFileW(reinterpret_cast<const wchar_t*>(m_fileName.utf16()), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+}
+
+/*
+ * Check whether the path now refers to a different file than the open handle
+ */
+bool CFileFollower::isReplaced(void *fileHandle) const
+{
+	//No file at the path (e.g. in the middle of the rotation), keep reading the old one
+	HANDLE current = CreateFileW(reinterpret_cast<const wchar_t*>(m_fileName.utf16()), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(current == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	BY_HANDLE_FILE_INFORMATION infoOld, infoNew;
+	bool replaced = false;
+
+	if(GetFileInformationByHandle(fileHandle, &infoOld) && GetFileInformationByHandle(current, &infoNew))
+	{
+		replaced = (infoOld.dwVolumeSerialNumber != infoNew.dwVolumeSerialNumber) || (infoOld.nFileIndexHigh != infoNew.nFileIndexHigh) || (infoOld.nFileIndexLow != infoNew.nFileIndexLow);
+	}
+
+	CloseHandle(current);
+	return replaced;
+}
+
+/*
+ * Read all data that has been appended since the given offset, returns the new offset
+ */
+qint64 CFileFollower::readNewData(void *fileHandle, qint64 offset, QByteArray &buffer)
+{
+	QElapsedTimer lastNotify;
+	lastNotify.start();
+
+	while(!m_aborted)
+	{
+		//Positioned read, so the file pointer does not matter
+		OVERLAPPED overlapped;
+		memset(&overlapped, 0, sizeof(OVERLAPPED));
+		overlapped.Offset = DWORD(offset & 0xFFFFFFFF);
+		overlapped.OffsetHigh = DWORD(offset >> 32);
+
+		DWORD bytesRead = 0;
+		if((!ReadFile(fileHandle, buffer.data(), buffer.size(), &bytesRead, &overlapped)) || (bytesRead < 1))
+		{
+			break;
+		}
+
+		offset += bytesRead;
+
+		storeData(buffer.constData(), bytesRead);
+
+		//A file that grows faster than we read must not starve the consumer until we reach its end
+		QMutexLocker lock(m_dataLock);
+		if(!m_signalPending)
+		{
+			const bool backlog = (qint64(m_data->size()) + (m_spillWrite - m_spillRead) >= qint64(READ_SIZE)) || (lastNotify.elapsed() >= MAX_NOTIFY_DELAY);
+			if(backlog)
+			{
+				m_signalPending = true;
+				const quint32 pendingBytes = m_data->size();
+				lock.unlock();
+				lastNotify.restart();
+				emit dataAvailable(pendingBytes);
+			}
+		}
+	}
+
+	//Otherwise the consumer is notified once the end of the file has been reached
+	QMutexLocker lock(m_dataLock);
+	if(((!m_data->isEmpty()) || (m_spillWrite > m_spillRead)) && (!m_signalPending))
+	{
+		m_signalPending = true;
+		const quint32 pendingBytes = m_data->size();
+		lock.unlock();
+		emit dataAvailable(pendingBytes);
+	}
+
+	return offset;
+}
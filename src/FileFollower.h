@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "InputReader.h"
+
+#include <QString>
+
+//Class CFileFollower
+//Follows a file that keeps growing, like "tail -F" (handles truncation and rotation by rename)
+class CFileFollower : public CInputReader
+{
+	Q_OBJECT;
+
+public:
+	CFileFollower(const QString &fileName);
+	~CFileFollower(void);
+
+	virtual void abort(void);
+
+signals:
+	void followEvent(const QString &message);
+
+protected:
+	virtual void run(void);
+
+private:
+	void *openFile(void) const;
+	bool isReplaced(void *fileHandle) const;
+	qint64 readNewData(void *fileHandle, qint64 offset, QByteArray &buffer);
+
+	const QString m_fileName;
+	void *m_abortEvent;
+};
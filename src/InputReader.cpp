@@ -28,17 +28,38 @@
 //Qt
 #include <QMutex>
 #include <QMutexLocker>
+#include <QTemporaryFile>
+#include <QDir>
+#include <QElapsedTimer>
+
+//Const
+static const DWORD MIN_READ_SIZE = 4096;
+static const DWORD MAX_READ_SIZE = 1048576;
+static const qint64 SPILL_CHUNK_SIZE = 4194304;
+static const qint64 MAX_NOTIFY_DELAY = 100;
+
+//Helper
+#define SAFE_DEL(X) do { if(X) { delete (X); X = NULL; } } while (0)
 
 /*
  * Constructor
  */
-CInputReader::CInputReader(void)
+CInputReader::CInputReader(void *inputHandle)
 :
+	m_inputHandle(inputHandle ? inputHandle : GetStdHandle(STD_INPUT_HANDLE)),
 	m_aborted(false),
+	m_signalPending(false),
+	m_maxRam(0),
+	m_maxSpill(0),
+	m_spillFile(NULL),
+	m_spillRead(0),
+	m_spillWrite(0),
+	m_droppedBytes(0),
 	m_threadHandle(INVALID_HANDLE_VALUE),
 	m_cancelSyncIo(NULL)
 {
 	m_dataLock = new QMutex();
+	m_spillLock = new QMutex();
 	m_data = new QByteArray();
 
 	if(HMODULE krnl32 = GetModuleHandleA("Kernel32.dll"))
@@ -54,6 +75,8 @@ CInputReader::~CInputReader(void)
 {
 	delete m_data;
 	delete m_dataLock;
+	delete m_spillLock;
+	SAFE_DEL(m_spillFile);
 
 	if(m_threadHandle != INVALID_HANDLE_VALUE)
 	{
@@ -75,6 +98,8 @@ void CInputReader::start(Priority priority)
  */
 void CInputReader::abort(void)
 {
+	//The thread handle is set up by the reader thread, so it must be accessed under the lock
+	QMutexLocker lock(m_dataLock);
 	m_aborted = true;
 	if(m_cancelSyncIo && (m_threadHandle != INVALID_HANDLE_VALUE))
 	{
@@ -87,43 +112,241 @@ void CInputReader::abort(void)
  */
 void CInputReader::run(void)
 {
-	//Setup thread handle
+	//Setup thread handle (the handle of a previous run is replaced)
+	QMutexLocker threadLock(m_dataLock);
+	if(m_threadHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_threadHandle);
+	}
 	if(!DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &m_threadHandle, 0, FALSE, DUPLICATE_SAME_ACCESS))
 	{
 		m_threadHandle = INVALID_HANDLE_VALUE;
 	}
+	threadLock.unlock();
 	
 	//Setup local variables
-	BYTE buffer[1024];
-	HANDLE h = GetStdHandle(STD_INPUT_HANDLE);
+	QByteArray buffer(int(MAX_READ_SIZE), '\0');
+	DWORD readSize = MIN_READ_SIZE;
 	DWORD bytesRead = 0;
+	QElapsedTimer lastNotify;
+	lastNotify.start();
 	
 	//Main processing loop
 	while(!m_aborted)
 	{
-		if(ReadFile(h, buffer, 1024, &bytesRead, NULL))
+		if(!ReadFile(m_inputHandle, buffer.data(), readSize, &bytesRead, NULL))
+		{
+			break;
+		}
+		if(bytesRead < 1)
+		{
+			break;
+		}
+
+		//Grow the read size while the pipe keeps delivering full reads
+		if((bytesRead >= readSize) && (readSize < MAX_READ_SIZE))
 		{
-			if(bytesRead > 0)
+			readSize *= 2;
+		}
+
+		//Keep draining the pipe, the consumer is notified once it is empty or enough data is pending
+		DWORD bytesAvailable = 0;
+		if(!PeekNamedPipe(m_inputHandle, NULL, 0, NULL, &bytesAvailable, NULL))
+		{
+			bytesAvailable = 0;
+		}
+		if(bytesAvailable < 1)
+		{
+			readSize = MIN_READ_SIZE;
+		}
+
+		storeData(buffer.constData(), bytesRead);
+
+		QMutexLocker lock(m_dataLock);
+		if(!m_signalPending)
+		{
+			//A writer that never lets the pipe run empty must not starve the consumer
+			const bool backlog = (qint64(m_data->size()) + (m_spillWrite - m_spillRead) >= qint64(MAX_READ_SIZE)) || (lastNotify.elapsed() >= MAX_NOTIFY_DELAY);
+			if((bytesAvailable < 1) || backlog)
 			{
-				QMutexLocker lock(m_dataLock);
-				m_data->append(reinterpret_cast<const char*>(buffer), bytesRead);
+				m_signalPending = true;
+				const quint32 pendingBytes = m_data->size();
 				lock.unlock();
-				emit dataAvailable(bytesRead);
-				continue;
+				lastNotify.restart();
+				emit dataAvailable(pendingBytes);
 			}
 		}
-		break;
+	}
+
+	//Make sure the consumer sees the remaining data
+	QMutexLocker lock(m_dataLock);
+	if(((!m_data->isEmpty()) || (m_spillWrite > m_spillRead)) && (!m_signalPending))
+	{
+		m_signalPending = true;
+		const quint32 pendingBytes = m_data->size();
+		lock.unlock();
+		emit dataAvailable(pendingBytes);
 	}
 }
 
 /*
- * Read all data currently available
+ * Store data in memory, or spill it to disk if the memory limit is reached (locks must NOT be held)
+ * The spill file is accessed under the spill lock only, the data lock just guards the offsets and buffers
+ */
+void CInputReader::storeData(const char *data, const int len)
+{
+	//Data goes to memory only while nothing is spilled, so the FIFO order is retained
+	QMutexLocker lock(m_dataLock);
+	if((m_spillWrite <= m_spillRead) && ((m_maxRam < 1) || ((m_data->size() + len) <= m_maxRam)))
+	{
+		m_data->append(data, len);
+		return;
+	}
+	lock.unlock();
+
+	//Only the producer appends to the spill file, the consumer cannot reset it while the spill lock is held
+	QMutexLocker spillLock(m_spillLock);
+	lock.relock();
+
+	//The consumer may have drained the spill file in the meantime
+	if((m_spillWrite <= m_spillRead) && ((m_maxRam < 1) || ((m_data->size() + len) <= m_maxRam)))
+	{
+		m_data->append(data, len);
+		return;
+	}
+
+	//Never block the producer, data is dropped if the spill file is full too
+	if((m_maxSpill > 0) && ((m_spillWrite + len) > m_maxSpill))
+	{
+		m_droppedBytes += len;
+		return;
+	}
+
+	const qint64 offset = m_spillWrite;
+	lock.unlock();
+
+	if(!m_spillFile)
+	{
+		m_spillFile = new QTemporaryFile(QDir::temp().absoluteFilePath("LoggingUtil_spill_XXXXXX.tmp"));
+		if(!m_spillFile->open())
+		{
+			SAFE_DEL(m_spillFile);
+			lock.relock();
+			m_droppedBytes += len;
+			return;
+		}
+	}
+
+	const qint64 written = (m_spillFile->seek(offset)) ? m_spillFile->write(data, len) : -1;
+
+	lock.relock();
+	if(written > 0)
+	{
+		m_spillWrite = offset + written;
+	}
+	if(written < len)
+	{
+		m_droppedBytes += (len - qMax(written, Q_INT64_C(0)));
+	}
+}
+
+/*
+ * Read all data currently available (buffers are swapped, if output is empty)
  */
 size_t CInputReader::readAllData(QByteArray &output)
 {
 	QMutexLocker lock(m_dataLock);
-	const size_t bytes = m_data->size();
-	output.append(m_data->constData(), bytes);
-	m_data->clear();
+	size_t bytes = m_data->size();
+
+	if(bytes > 0)
+	{
+		if(output.isEmpty())
+		{
+			qSwap(output, *m_data);
+			m_data->resize(0);
+		}
+		else
+		{
+			output.append(m_data->constData(), bytes);
+			m_data->resize(0);
+		}
+	}
+	else if(m_spillWrite > m_spillRead)
+	{
+		//Lock order is spill lock first, then data lock
+		lock.unlock();
+		QMutexLocker spillLock(m_spillLock);
+		lock.relock();
+
+		//Drain the spill file in chunks, so the memory usage remains bounded
+		const qint64 offset = m_spillRead;
+		const qint64 chunkSize = qMin(m_spillWrite - m_spillRead, (m_maxRam > 0) ? m_maxRam : SPILL_CHUNK_SIZE);
+		lock.unlock();
+
+		const QByteArray spilled = ((chunkSize > 0) && m_spillFile->seek(offset)) ? m_spillFile->read(chunkSize) : QByteArray();
+		output.append(spilled);
+		bytes = spilled.size();
+
+		lock.relock();
+		m_spillRead += spilled.isEmpty() ? chunkSize : spilled.size();
+		if(spilled.isEmpty())
+		{
+			m_droppedBytes += chunkSize;
+		}
+
+		//The producer is waiting for the spill lock, so the file can be reset safely
+		const bool drained = (m_spillRead >= m_spillWrite);
+		if(drained)
+		{
+			m_spillRead = m_spillWrite = 0;
+		}
+		lock.unlock();
+
+		if(drained)
+		{
+			m_spillFile->resize(0);
+		}
+
+		spillLock.unlock();
+		lock.relock();
+	}
+
+	//Make sure the consumer comes back for the data that is still spilled
+	m_signalPending = (m_spillWrite > m_spillRead);
+	if(m_signalPending)
+	{
+		const quint32 pendingBytes = quint32(qMin(m_spillWrite - m_spillRead, Q_INT64_C(0xFFFFFFFF)));
+		lock.unlock();
+		emit dataAvailable(pendingBytes);
+	}
+
 	return bytes;
 }
+
+/*
+ * Set limits for buffered data in memory and in the spill file (zero means unlimited)
+ */
+void CInputReader::setBufferLimits(const qint64 maxRam, const qint64 maxSpill)
+{
+	QMutexLocker lock(m_dataLock);
+	m_maxRam = qMax(maxRam, Q_INT64_C(0));
+	m_maxSpill = qMax(maxSpill, Q_INT64_C(0));
+}
+
+/*
+ * Number of bytes that have not been read yet (in memory or spilled)
+ */
+qint64 CInputReader::pendingBytes(void) const
+{
+	QMutexLocker lock(m_dataLock);
+	return m_data->size() + (m_spillWrite - m_spillRead);
+}
+
+/*
+ * Number of bytes that had to be dropped, because all buffers were full
+ */
+quint64 CInputReader::droppedBytes(void) const
+{
+	QMutexLocker lock(m_dataLock);
+	return m_droppedBytes;
+}
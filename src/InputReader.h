@@ -25,6 +25,7 @@
 
 //Forward declartion
 class QMutex;
+class QTemporaryFile;
 
 //Typedef
 typedef int (__stdcall *FunCancelSynchronousIo)(void *hThread);
@@ -35,11 +36,15 @@ class CInputReader : public QThread
 	Q_OBJECT;
 
 public:
-	CInputReader(void);
+	CInputReader(void *inputHandle = NULL);
 	~CInputReader(void);
 
 	size_t readAllData(QByteArray &output);
-	void abort(void);
+	virtual void abort(void);
+
+	void setBufferLimits(const qint64 maxRam, const qint64 maxSpill);
+	qint64 pendingBytes(void) const;
+	quint64 droppedBytes(void) const;
 
 signals:
 	void dataAvailable(quint32 newBytes);
@@ -49,10 +54,22 @@ public slots:
 
 protected:
 	virtual void run(void);
+	void storeData(const char *data, const int len);
 
 	volatile bool m_aborted;
 	QByteArray *m_data;
 	QMutex *m_dataLock;
+	QMutex *m_spillLock;
+	bool m_signalPending;
+
+	qint64 m_maxRam;
+	qint64 m_maxSpill;
+	QTemporaryFile *m_spillFile;
+	qint64 m_spillRead;
+	qint64 m_spillWrite;
+	quint64 m_droppedBytes;
+
+	void *const m_inputHandle;
 
 	FunCancelSynchronousIo m_cancelSyncIo;
 	void *m_threadHandle;
@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "LatencyTracer.h"
+
+//Qt
+#include <QFile>
+#include <QFileInfo>
+#include <QCoreApplication>
+
+//Const
+static const char *CHANNEL_NAMES[32] =
+{
+	"", "stdout", "stderr", "", "stdin", "", "", "", "system", "", "", "", "", "", "", "",
+	"file", "", "", "", "", "", "", "", "", "", "", "", "", "", "", ""
+};
+
+//Helper
+#define SAFE_DEL(X) do { if(X) { delete (X); X = NULL; } } while (0)
+
+/*
+ * Constructor
+ */
+CLatencyTracer::CLatencyTracer(const quint32 sampleEvery)
+:
+	m_sampleEvery(qMax(sampleEvery, 1U)),
+	m_chunks(0),
+	m_active(false),
+	m_channel(0),
+	m_events(0),
+	m_traceFile(NULL)
+{
+	m_processId = QCoreApplication::applicationPid();
+	m_timer.start();
+}
+
+/*
+ * Destructor
+ */
+CLatencyTracer::~CLatencyTracer(void)
+{
+	if(m_traceFile)
+	{
+		m_traceFile->write("\n]\n");
+		m_traceFile->close();
+		SAFE_DEL(m_traceFile);
+	}
+}
+
+/*
+ * Create the trace file (an existing file is overwritten)
+ */
+bool CLatencyTracer::open(const QString &fileName)
+{
+	SAFE_DEL(m_traceFile);
+
+	m_traceFile = new QFile(QFileInfo(fileName).absoluteFilePath());
+	if(!m_traceFile->open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		SAFE_DEL(m_traceFile);
+		return false;
+	}
+
+	m_traceFile->write("[");
+	m_events = 0;
+	return true;
+}
+
+/*
+ * Write a complete event of the current chunk, one thread lane per channel
+ */
+void CLatencyTracer::complete(const char *stage, const qint64 begin, const qint64 count)
+{
+	if(!m_traceFile)
+	{
+		return;
+	}
+
+	const qint64 end = now();
+	const QString event = QString().sprintf("%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%I64d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"count\":%I64d}}",
+		(m_events > 0) ? "," : "", stage, CHANNEL_NAMES[m_channel & 0x1F], m_processId, m_channel, double(begin) / 1000.0, double(end - begin) / 1000.0, count);
+
+	m_traceFile->write(event.toLatin1());
+	m_events++;
+}
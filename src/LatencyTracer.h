@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QString>
+#include <QElapsedTimer>
+
+//Forward declaration
+class QFile;
+
+//Class CLatencyTracer
+//Records the processing stages of every N-th chunk of input as Chrome trace events (JSON array format)
+class CLatencyTracer
+{
+public:
+	CLatencyTracer(const quint32 sampleEvery);
+	~CLatencyTracer(void);
+
+	bool open(const QString &fileName);
+
+	//Sampling
+	void beginChunk(const int channel) { m_active = ((m_chunks++ % m_sampleEvery) == 0); m_channel = channel; }
+	void endChunk(void) { m_active = false; }
+	bool isActive(void) const { return m_active; }
+
+	//Recording (times are in nanoseconds since the tracer was created)
+	qint64 now(void) const { return m_timer.nsecsElapsed(); }
+	void complete(const char *stage, const qint64 begin, const qint64 count);
+
+private:
+	CLatencyTracer(const CLatencyTracer&);
+	CLatencyTracer &operator=(const CLatencyTracer&);
+
+	const quint32 m_sampleEvery;
+	quint32 m_chunks;
+	bool m_active;
+	int m_channel;
+	quint64 m_events;
+	qint64 m_processId;
+
+	QElapsedTimer m_timer;
+	QFile *m_traceFile;
+};
+
+//Class CTraceChunk
+//Decides whether the chunk of the channel that is read in this scope will be traced
+class CTraceChunk
+{
+public:
+	CTraceChunk(CLatencyTracer *tracer, const int channel) : m_tracer(tracer) { if(m_tracer) m_tracer->beginChunk(channel); }
+	~CTraceChunk(void) { if(m_tracer) m_tracer->endChunk(); }
+
+private:
+	CTraceChunk(const CTraceChunk&);
+	CTraceChunk &operator=(const CTraceChunk&);
+
+	CLatencyTracer *const m_tracer;
+};
+
+//Class CTraceStage
+//Records the duration of this scope, if the current chunk is traced
+class CTraceStage
+{
+public:
+	CTraceStage(CLatencyTracer *tracer, const char *stage, const qint64 count)
+	:
+		m_tracer((tracer && tracer->isActive()) ? tracer : NULL), m_stage(stage), m_count(count), m_begin(m_tracer ? m_tracer->now() : 0)
+	{
+	}
+	~CTraceStage(void) { if(m_tracer) m_tracer->complete(m_stage, m_begin, m_count); }
+
+private:
+	CTraceStage(const CTraceStage&);
+	CTraceStage &operator=(const CTraceStage&);
+
+	CLatencyTracer *const m_tracer;
+	const char *const m_stage;
+	const qint64 m_count;
+	const qint64 m_begin;
+};
+
+//Tracing can be removed at compile-time by defining NO_LATENCY_TRACE
+#ifdef NO_LATENCY_TRACE
+#define TRACE_CHUNK(TRACER, CHANNEL) ((void)0)
+#define TRACE_STAGE(TRACER, STAGE, COUNT) ((void)0)
+#else
+#define TRACE_CHUNK(TRACER, CHANNEL) const CTraceChunk traceChunk(TRACER, CHANNEL)
+#define TRACE_STAGE(TRACER, STAGE, COUNT) const CTraceStage traceStage(TRACER, STAGE, COUNT)
+#endif //NO_LATENCY_TRACE
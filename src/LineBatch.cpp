@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LineBatch.h"
+
+//CRT
+#include <cstring>
+
+//Const
+static const int INITIAL_ARENA_SIZE = 65536;
+static const int INITIAL_LINE_COUNT = 1024;
+
+/*
+ * Constructor
+ */
+CLineBatch::CLineBatch(void)
+:
+	m_arenaSize(INITIAL_ARENA_SIZE),
+	m_arenaUsed(0),
+	m_raw(NULL),
+	m_rawSize(0),
+	m_rawUsed(0),
+	m_records(0),
+	m_timeStamp(0)
+{
+	m_arena = static_cast<QChar*>(qMalloc(m_arenaSize * sizeof(QChar)));
+	if(!m_arena)
+	{
+		throw "Memory allocation failed!";
+	}
+
+	m_lines.reserve(INITIAL_LINE_COUNT);
+	m_output.reserve(2 * INITIAL_ARENA_SIZE);
+}
+
+/*
+ * Destructor
+ */
+CLineBatch::~CLineBatch(void)
+{
+	qFree(m_arena);
+	qFree(m_raw);
+}
+
+/*
+ * Copy line into the arena (and simplify it in-place)
+ */
+void CLineBatch::append(const QChar *data, const int len, const int channel, const qint64 timeStamp, const bool simplify)
+{
+	//Grow the arena, only needed until the steady state is reached
+	if(m_arenaUsed + len > m_arenaSize)
+	{
+		while(m_arenaUsed + len > m_arenaSize) m_arenaSize *= 2;
+		QChar *arena = static_cast<QChar*>(qRealloc(m_arena, m_arenaSize * sizeof(QChar)));
+		if(!arena)
+		{
+			throw "Memory allocation failed!";
+		}
+		m_arena = arena;
+	}
+
+	QChar *const payload = m_arena + m_arenaUsed;
+	memcpy(payload, data, len * sizeof(QChar));
+
+	line_t line;
+	line.offset = m_arenaUsed;
+	line.length = simplify ? CLogFormatter::simplify(payload, len) : len;
+	line.channel = channel;
+	line.timeStamp = timeStamp;
+
+	m_arenaUsed += line.length;
+	m_lines.append(line);
+}
+
+/*
+ * Filter and format all lines of the batch
+ */
+void CLineBatch::format(const CLogFormatter &formatter)
+{
+	m_output.resize(0);
+	m_timeStamp = m_lines.isEmpty() ? 0 : m_lines.first().timeStamp;
+	m_records = formatter.formatBatch(m_output, m_arena, m_lines.constData(), m_lines.count());
+}
+
+/*
+ * Split bytes into lines and format them without decoding (the final line needs no line break)
+ */
+void CLineBatch::formatRaw(const CLogFormatter &formatter, const char *data, const int len, const int channel, const qint64 timeStamp)
+{
+	if((m_rawUsed == 0) && (m_records == 0))
+	{
+		m_timeStamp = timeStamp;
+	}
+
+	int start = 0;
+	while(start < len)
+	{
+		int end = start;
+		while((end < len) && (!CLogFormatter::isLineBreak(data[end]))) end++;
+
+		if(end > start)
+		{
+			reserveRaw(end - start + RAW_PREFIX_MAX + 2);
+			m_rawUsed += formatter.formatRaw(m_raw + m_rawUsed, data + start, end - start, channel, timeStamp);
+			m_records++;
+		}
+
+		start = end + 1;
+	}
+}
+
+/*
+ * Reset the batch, memory is retained for re-use
+ */
+void CLineBatch::reset(void)
+{
+	m_arenaUsed = 0;
+	m_rawUsed = 0;
+	m_lines.resize(0);
+	m_output.resize(0);
+	m_records = 0;
+	m_timeStamp = 0;
+}
+
+/*
+ * Make room for more raw output, the buffer is allocated on first use only
+ */
+void CLineBatch::reserveRaw(const int len)
+{
+	if(m_rawUsed + len > m_rawSize)
+	{
+		int rawSize = qMax(m_rawSize, INITIAL_ARENA_SIZE);
+		while(m_rawUsed + len > rawSize) rawSize *= 2;
+		char *raw = static_cast<char*>(qRealloc(m_raw, rawSize));
+		if(!raw)
+		{
+			throw "Memory allocation failed!";
+		}
+		m_raw = raw;
+		m_rawSize = rawSize;
+	}
+}
@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+//Internal
+#include "LogFormatter.h"
+
+//Class CLineBatch
+//Lines are stored in a bump arena, which keeps its memory when the batch is reset
+class CLineBatch
+{
+public:
+	CLineBatch(void);
+	~CLineBatch(void);
+
+	//Batch processing
+	void append(const QChar *data, const int len, const int channel, const qint64 timeStamp, const bool simplify);
+	void format(const CLogFormatter &formatter);
+	void formatRaw(const CLogFormatter &formatter, const char *data, const int len, const int channel, const qint64 timeStamp);
+	void reset(void);
+
+	//Getter methods
+	int count(void) const { return m_lines.count(); }
+	bool isEmpty(void) const { return m_lines.isEmpty(); }
+	const QString &output(void) const { return m_output; }
+	quint32 records(void) const { return m_records; }
+	qint64 timeStamp(void) const { return m_timeStamp; }
+	const QChar *arena(void) const { return m_arena; }
+	const line_t *lines(void) const { return m_lines.constData(); }
+	const char *rawOutput(void) const { return m_raw; }
+	int rawLength(void) const { return m_rawUsed; }
+
+private:
+	CLineBatch(const CLineBatch&);
+	CLineBatch &operator=(const CLineBatch&);
+
+	void reserveRaw(const int len);
+
+	QChar *m_arena;
+	int m_arenaSize;
+	int m_arenaUsed;
+
+	QVector<line_t> m_lines;
+	QString m_output;
+
+	char *m_raw;
+	int m_rawSize;
+	int m_rawUsed;
+
+	quint32 m_records;
+	qint64 m_timeStamp;
+};
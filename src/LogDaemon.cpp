@@ -0,0 +1,635 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "LogDaemon.h"
+
+//Windows
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+//Qt
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutexLocker>
+#include <QTimer>
+
+//CRT
+#include <cstdio>
+#include <cstring>
+
+//Internal
+#include "LogProcessor.h"
+
+//Const
+static const quint32 DAEMON_MAGIC = 0x44554C01; //"\x01LUD"
+static const quint32 MAX_HEADER_SIZE = 65536;
+static const DWORD PIPE_BUFFER_SIZE = 65536;
+static const DWORD HEADER_TIMEOUT = 5000;
+static const int HEADER_POLL_INTERVAL = 10;
+static const DWORD CONNECT_TIMEOUT = 5000;
+
+//Helper
+#define SAFE_DEL(X) do { if(X) { delete (X); X = NULL; } } while (0)
+
+//Forward declarations
+static HANDLE createPipe(const QString &pipePath, const bool firstInstance);
+static void closePipe(HANDLE pipe);
+static int readHeader(HANDLE pipe, QByteArray &buffer, QStringList &arguments);
+static bool writeAll(HANDLE pipe, const char *data, const DWORD len);
+
+// ===================================================
+// Daemon
+// ===================================================
+
+/*
+ * Constructor
+ */
+CLogDaemon::CLogDaemon(SessionFactory factory)
+:
+	m_factory(factory),
+	m_listener(NULL),
+	m_nextWorker(0),
+	m_runningThreads(0),
+	m_stopping(false)
+{
+}
+
+/*
+ * Destructor
+ */
+CLogDaemon::~CLogDaemon(void)
+{
+	if(m_listener)
+	{
+		m_listener->abort();
+		m_listener->wait();
+		SAFE_DEL(m_listener);
+	}
+
+	//Sessions that are still open get closed by the worker
+	for(int i = 0; i < m_threads.count(); i++)
+	{
+		m_threads.at(i)->quit();
+		m_threads.at(i)->wait();
+	}
+
+	qDeleteAll(m_workers);
+	qDeleteAll(m_threads);
+}
+
+/*
+ * Create the pipe and start the event-loop threads
+ */
+bool CLogDaemon::start(const QString &pipeName, const int threadCount)
+{
+	if(m_listener)
+	{
+		return false;
+	}
+
+	//Creating the first instance fails, if another daemon is already using this pipe
+	const QString path = pipePath(pipeName);
+	HANDLE firstInstance = createPipe(path, true);
+	if(firstInstance == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	for(int i = 0; i < qMax(threadCount, 1); i++)
+	{
+		QThread *thread = new QThread();
+		CDaemonWorker *worker = new CDaemonWorker(m_factory);
+		worker->moveToThread(thread);
+		connect(thread, SIGNAL(finished()), this, SLOT(threadFinished()), Qt::QueuedConnection);
+		m_threads.append(thread);
+		m_workers.append(worker);
+		thread->start();
+		m_runningThreads++;
+	}
+
+	m_listener = new CPipeListener(path, firstInstance);
+	connect(m_listener, SIGNAL(clientConnected()), this, SLOT(clientConnected()), Qt::QueuedConnection);
+	m_listener->start();
+
+	return true;
+}
+
+/*
+ * Stop accepting clients and finish all open sessions
+ */
+void CLogDaemon::shutdown(void)
+{
+	if(m_stopping)
+	{
+		return;
+	}
+
+	m_stopping = true;
+
+	if(m_listener)
+	{
+		m_listener->abort();
+		m_listener->wait();
+		clientConnected();
+	}
+
+	for(int i = 0; i < m_workers.count(); i++)
+	{
+		QMetaObject::invokeMethod(m_workers.at(i), "stopSessions", Qt::QueuedConnection);
+	}
+
+	if(m_runningThreads < 1)
+	{
+		QCoreApplication::quit();
+	}
+}
+
+/*
+ * Assign new clients to the event-loop threads (round robin)
+ */
+void CLogDaemon::clientConnected(void)
+{
+	void *pipeHandle = NULL;
+
+	while(m_listener->takeClient(pipeHandle))
+	{
+		if(m_stopping || m_workers.isEmpty())
+		{
+			closePipe(pipeHandle);
+			continue;
+		}
+
+		CDaemonWorker *worker = m_workers.at(m_nextWorker);
+		m_nextWorker = (m_nextWorker + 1) % m_workers.count();
+
+		worker->enqueue(pipeHandle);
+		QMetaObject::invokeMethod(worker, "startSessions", Qt::QueuedConnection);
+	}
+}
+
+/*
+ * Event-loop thread has finished (after shutdown)
+ */
+void CLogDaemon::threadFinished(void)
+{
+	if((--m_runningThreads < 1) && m_stopping)
+	{
+		QCoreApplication::quit();
+	}
+}
+
+/*
+ * Connect to a running daemon and forward all data from STDIN
+ */
+bool CLogDaemon::forward(const QString &pipeName, const QStringList &arguments)
+{
+	const QString path = pipePath(pipeName);
+	const wchar_t *const pathStr = reinterpret_cast<const wchar_t*>(path.utf16());
+
+	//All pipe instances may be busy for a moment, while the listener accepts other clients
+	HANDLE pipe = INVALID_HANDLE_VALUE;
+	for(;;)
+	{
+		pipe = CreateFileW(pathStr, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+		if((pipe != INVALID_HANDLE_VALUE) || (GetLastError() != ERROR_PIPE_BUSY) || (!WaitNamedPipeW(pathStr, CONNECT_TIMEOUT)))
+		{
+			break;
+		}
+	}
+
+	if(pipe == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	//Send the session header (the logger options)
+	const QByteArray payload = arguments.join(QString(QChar('\0'))).toUtf8();
+	const quint32 header[2] = { DAEMON_MAGIC, quint32(payload.size()) };
+	bool success = (payload.size() <= int(MAX_HEADER_SIZE)) && writeAll(pipe, reinterpret_cast<const char*>(header), sizeof(header)) && writeAll(pipe, payload.constData(), payload.size());
+
+	//Forward the data, echo to STDERR just like the processor does
+	HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+	QByteArray buffer(PIPE_BUFFER_SIZE, '\0');
+	while(success)
+	{
+		DWORD bytesRead = 0;
+		if(!(ReadFile(input, buffer.data(), buffer.size(), &bytesRead, NULL) && (bytesRead > 0)))
+		{
+			break;
+		}
+		fwrite(buffer.constData(), 1, bytesRead, stderr);
+		fflush(stderr);
+		success = writeAll(pipe, buffer.constData(), bytesRead);
+	}
+
+	FlushFileBuffers(pipe);
+	CloseHandle(pipe);
+	return success;
+}
+
+/*
+ * Full path of the named pipe
+ */
+QString CLogDaemon::pipePath(const QString &pipeName)
+{
+	return QString("\\\\.\\pipe\\%1").arg(pipeName);
+}
+
+// ===================================================
+// Listener
+// ===================================================
+
+/*
+ * Constructor
+ */
+CPipeListener::CPipeListener(const QString &pipePath, void *firstInstance)
+:
+	m_pipePath(pipePath),
+	m_nextInstance(firstInstance),
+	m_aborted(false)
+{
+}
+
+/*
+ * Destructor
+ */
+CPipeListener::~CPipeListener(void)
+{
+	if(m_nextInstance)
+	{
+		CloseHandle(m_nextInstance);
+	}
+
+	for(int i = 0; i < m_pendingHandles.count(); i++)
+	{
+		closePipe(m_pendingHandles.at(i));
+	}
+}
+
+/*
+ * Thread main
+ */
+void CPipeListener::run(void)
+{
+	while(!m_aborted)
+	{
+		HANDLE pipe = m_nextInstance ? m_nextInstance : createPipe(m_pipePath, false);
+		m_nextInstance = NULL;
+
+		if(pipe == INVALID_HANDLE_VALUE)
+		{
+			Sleep(100);
+			continue;
+		}
+
+		const bool connected = ConnectNamedPipe(pipe, NULL) || (GetLastError() == ERROR_PIPE_CONNECTED);
+		if(m_aborted || (!connected))
+		{
+			closePipe(pipe);
+			continue;
+		}
+
+		QMutexLocker lock(&m_lock);
+		m_pendingHandles.append(pipe);
+		lock.unlock();
+
+		emit clientConnected();
+	}
+}
+
+/*
+ * Take the next client that has connected
+ */
+bool CPipeListener::takeClient(void *&pipeHandle)
+{
+	QMutexLocker lock(&m_lock);
+
+	if(m_pendingHandles.isEmpty())
+	{
+		return false;
+	}
+
+	pipeHandle = m_pendingHandles.takeFirst();
+	return true;
+}
+
+/*
+ * Stop listening (connects a dummy client to unblock the pending ConnectNamedPipe)
+ */
+void CPipeListener::abort(void)
+{
+	m_aborted = true;
+
+	HANDLE dummy = CreateFileW(reinterpret_cast<const wchar_t*>(m_pipePath.utf16()), GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+	if(dummy != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(dummy);
+	}
+}
+
+// ===================================================
+// Worker
+// ===================================================
+
+/*
+ * Constructor
+ */
+CDaemonWorker::CDaemonWorker(SessionFactory factory)
+:
+	m_factory(factory),
+	m_stopping(false),
+	m_headerTimer(NULL)
+{
+}
+
+/*
+ * Destructor
+ */
+CDaemonWorker::~CDaemonWorker(void)
+{
+	for(int i = 0; i < m_pendingHandles.count(); i++)
+	{
+		closePipe(m_pendingHandles.at(i));
+	}
+
+	for(int i = 0; i < m_handshakes.count(); i++)
+	{
+		closePipe(m_handshakes.at(i).pipeHandle);
+	}
+
+	for(int i = 0; i < m_sessions.count(); i++)
+	{
+		closeSession(m_sessions[i]);
+	}
+}
+
+/*
+ * Add client, the session will be started by the worker's thread
+ */
+void CDaemonWorker::enqueue(void *pipeHandle)
+{
+	QMutexLocker lock(&m_lock);
+	m_pendingHandles.append(pipeHandle);
+}
+
+/*
+ * Start reading the session headers of all clients that have been assigned to this worker
+ */
+void CDaemonWorker::startSessions(void)
+{
+	QMutexLocker lock(&m_lock);
+	QList<void*> pendingHandles;
+	qSwap(pendingHandles, m_pendingHandles);
+	lock.unlock();
+
+	for(int i = 0; i < pendingHandles.count(); i++)
+	{
+		handshake_t handshake;
+		handshake.pipeHandle = pendingHandles.at(i);
+		handshake.startTime = GetTickCount();
+		m_handshakes.append(handshake);
+	}
+
+	readHeaders();
+}
+
+/*
+ * Read whatever part of the session headers has arrived, sessions are started once their header is complete
+ */
+void CDaemonWorker::readHeaders(void)
+{
+	for(int i = 0; i < m_handshakes.count(); i++)
+	{
+		handshake_t &handshake = m_handshakes[i];
+		QStringList arguments;
+		const int result = m_stopping ? -1 : readHeader(handshake.pipeHandle, handshake.header, arguments);
+
+		if((result == 0) && ((GetTickCount() - handshake.startTime) <= HEADER_TIMEOUT))
+		{
+			continue;
+		}
+
+		void *const pipeHandle = handshake.pipeHandle;
+		m_handshakes.removeAt(i--);
+
+		if(result > 0)
+		{
+			startSession(pipeHandle, arguments);
+			continue;
+		}
+
+		//Invalid header, client gone or too slow
+		closePipe(pipeHandle);
+	}
+
+	//Come back later for the headers that are still incomplete
+	if(!m_handshakes.isEmpty())
+	{
+		if(!m_headerTimer)
+		{
+			m_headerTimer = new QTimer(this);
+			m_headerTimer->setSingleShot(true);
+			connect(m_headerTimer, SIGNAL(timeout()), this, SLOT(readHeaders()));
+		}
+		if(!m_headerTimer->isActive())
+		{
+			m_headerTimer->start(HEADER_POLL_INTERVAL);
+		}
+	}
+}
+
+/*
+ * Start a session for a client whose header has been read
+ */
+void CDaemonWorker::startSession(void *pipeHandle, const QStringList &arguments)
+{
+	session_t session;
+	session.pipeHandle = pipeHandle;
+	session.logFile = NULL;
+	session.processor = m_stopping ? NULL : m_factory(arguments, session.pipeHandle, session.logFile);
+
+	if(!session.processor)
+	{
+		closeSession(session);
+		return;
+	}
+
+	connect(session.processor, SIGNAL(finished(int)), this, SLOT(sessionFinished()), Qt::QueuedConnection);
+	if(!session.processor->startStdinProcessing())
+	{
+		closeSession(session);
+		return;
+	}
+
+	m_sessions.append(session);
+}
+
+/*
+ * Abort all sessions, the thread quits once the last session has finished
+ */
+void CDaemonWorker::stopSessions(void)
+{
+	m_stopping = true;
+	startSessions();
+
+	for(int i = 0; i < m_sessions.count(); i++)
+	{
+		m_sessions.at(i).processor->forceQuit();
+	}
+
+	if(m_sessions.isEmpty())
+	{
+		thread()->quit();
+	}
+}
+
+/*
+ * Session has finished, all of its resources are released
+ */
+void CDaemonWorker::sessionFinished(void)
+{
+	for(int i = 0; i < m_sessions.count(); i++)
+	{
+		if(m_sessions.at(i).processor == sender())
+		{
+			session_t session = m_sessions.takeAt(i);
+			closeSession(session);
+			break;
+		}
+	}
+
+	if(m_stopping && m_sessions.isEmpty())
+	{
+		thread()->quit();
+	}
+}
+
+/*
+ * Release processor, log file and pipe of the session
+ */
+void CDaemonWorker::closeSession(session_t &session)
+{
+	SAFE_DEL(session.processor);
+
+	if(session.logFile)
+	{
+		session.logFile->close();
+		SAFE_DEL(session.logFile);
+	}
+
+	if(session.pipeHandle)
+	{
+		closePipe(session.pipeHandle);
+		session.pipeHandle = NULL;
+	}
+}
+
+// ===================================================
+// Misc Stuff
+// ===================================================
+
+/*
+ * Create a new instance of the inbound pipe
+ */
+static HANDLE createPipe(const QString &pipePath, const bool firstInstance)
+{
+	const DWORD openMode = PIPE_ACCESS_INBOUND | (firstInstance ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0);
+	return CreateNamedPipeW(reinterpret_cast<const wchar_t*>(pipePath.utf16()), openMode, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT, PIPE_UNLIMITED_INSTANCES, 0, PIPE_BUFFER_SIZE, 0, NULL);
+}
+
+/*
+ * Disconnect the client and close the pipe instance
+ */
+static void closePipe(HANDLE pipe)
+{
+	DisconnectNamedPipe(pipe);
+	CloseHandle(pipe);
+}
+
+/*
+ * Read the available part of the session header without blocking, returns 1 when complete, 0 when incomplete and -1 on error
+ * Bytes after the header are left in the pipe, they are read by the session
+ */
+static int readHeader(HANDLE pipe, QByteArray &buffer, QStringList &arguments)
+{
+	quint32 header[2];
+
+	for(;;)
+	{
+		int needed = int(sizeof(header)) - buffer.size();
+		if(needed <= 0)
+		{
+			memcpy(header, buffer.constData(), sizeof(header));
+			if((header[0] != DAEMON_MAGIC) || (header[1] > MAX_HEADER_SIZE))
+			{
+				return -1;
+			}
+			needed = int(sizeof(header) + header[1]) - buffer.size();
+			if(needed <= 0)
+			{
+				arguments = QString::fromUtf8(buffer.constData() + sizeof(header), header[1]).split(QChar('\0'));
+				return 1;
+			}
+		}
+
+		DWORD bytesAvailable = 0;
+		if(!PeekNamedPipe(pipe, NULL, 0, NULL, &bytesAvailable, NULL))
+		{
+			return -1;
+		}
+		if(bytesAvailable < 1)
+		{
+			return 0;
+		}
+
+		//Only data that is available is read, so this never blocks
+		const int offset = buffer.size();
+		const DWORD len = qMin(bytesAvailable, DWORD(needed));
+		DWORD bytesRead = 0;
+		buffer.resize(offset + len);
+		if(!(ReadFile(pipe, buffer.data() + offset, len, &bytesRead, NULL) && (bytesRead > 0)))
+		{
+			return -1;
+		}
+		buffer.resize(offset + bytesRead);
+	}
+}
+
+/*
+ * Write all data to the pipe
+ */
+static bool writeAll(HANDLE pipe, const char *data, const DWORD len)
+{
+	DWORD totalBytes = 0;
+
+	while(totalBytes < len)
+	{
+		DWORD bytesWritten = 0;
+		if(!(WriteFile(pipe, data + totalBytes, len - totalBytes, &bytesWritten, NULL) && (bytesWritten > 0)))
+		{
+			return false;
+		}
+		totalBytes += bytesWritten;
+	}
+
+	return true;
+}
@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QThread>
+#include <QStringList>
+#include <QList>
+#include <QMutex>
+
+//Forward declaration
+class QFile;
+class QTimer;
+class CLogProcessor;
+class CPipeListener;
+class CDaemonWorker;
+
+//Typedef
+typedef CLogProcessor *(*SessionFactory)(const QStringList &arguments, void *inputHandle, QFile *&logFile);
+
+//Class CLogDaemon
+//Serves many producers from one process: clients connect via a named pipe, sessions are hosted on a fixed pool of event-loop threads
+class CLogDaemon : public QObject
+{
+	Q_OBJECT
+
+public:
+	CLogDaemon(SessionFactory factory);
+	~CLogDaemon(void);
+
+	bool start(const QString &pipeName, const int threadCount);
+
+	//Client side
+	static bool forward(const QString &pipeName, const QStringList &arguments);
+	static QString pipePath(const QString &pipeName);
+
+public slots:
+	void shutdown(void);
+
+private slots:
+	void clientConnected(void);
+	void threadFinished(void);
+
+private:
+	const SessionFactory m_factory;
+	CPipeListener *m_listener;
+	QList<QThread*> m_threads;
+	QList<CDaemonWorker*> m_workers;
+	int m_nextWorker;
+	int m_runningThreads;
+	bool m_stopping;
+};
+
+//Class CPipeListener
+//Accepts client connections, so the event-loop threads never block in ConnectNamedPipe
+class CPipeListener : public QThread
+{
+	Q_OBJECT
+
+public:
+	CPipeListener(const QString &pipePath, void *firstInstance);
+	~CPipeListener(void);
+
+	bool takeClient(void *&pipeHandle);
+	void abort(void);
+
+signals:
+	void clientConnected(void);
+
+protected:
+	virtual void run(void);
+
+	const QString m_pipePath;
+	void *m_nextInstance;
+	volatile bool m_aborted;
+
+	QMutex m_lock;
+	QList<void*> m_pendingHandles;
+};
+
+//Class CDaemonWorker
+//Lives in one of the event-loop threads and owns the sessions that have been assigned to it
+//There is no shared writer stage: sessions write their logs on this thread, so a slow disk or sync delays the other sessions of the worker
+//The session header is read by polling the pipe from the event loop, so a slow client never blocks the other sessions
+class CDaemonWorker : public QObject
+{
+	Q_OBJECT
+
+public:
+	CDaemonWorker(SessionFactory factory);
+	~CDaemonWorker(void);
+
+	void enqueue(void *pipeHandle);
+
+public slots:
+	void startSessions(void);
+	void stopSessions(void);
+
+private slots:
+	void readHeaders(void);
+	void sessionFinished(void);
+
+private:
+	typedef struct
+	{
+		void *pipeHandle;
+		QByteArray header;
+		quint32 startTime;
+	}
+	handshake_t;
+
+	typedef struct
+	{
+		void *pipeHandle;
+		QFile *logFile;
+		CLogProcessor *processor;
+	}
+	session_t;
+
+	void startSession(void *pipeHandle, const QStringList &arguments);
+	void closeSession(session_t &session);
+
+	const SessionFactory m_factory;
+	bool m_stopping;
+
+	QMutex m_lock;
+	QList<void*> m_pendingHandles;
+	QList<handshake_t> m_handshakes;
+	QTimer *m_headerTimer;
+	QList<session_t> m_sessions;
+};
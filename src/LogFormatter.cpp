@@ -0,0 +1,553 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LogFormatter.h"
+
+//Windows
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+//Qt
+#include <QDateTime>
+
+//SIMD
+#if defined(_M_IX86) || defined(_M_X64)
+#define HAVE_SSE2_KERNEL 1
+#include <intrin.h>
+#include <emmintrin.h>
+#endif
+
+//CRT
+#include <cstring>
+
+//Typedef
+typedef void (WINAPI *FunGetSystemTimePreciseAsFileTime)(LPFILETIME lpSystemTimeAsFileTime);
+
+//Forward declarations
+static bool detectSSE2(void);
+static __forceinline void simplifyStep(QChar *data, const QChar c, int &out, bool &pendingSpace);
+static FunGetSystemTimePreciseAsFileTime lookupPreciseTime(void);
+
+//Const
+static const bool g_useSSE2 = detectSSE2();
+static const qint64 FILETIME_EPOCH_OFFSET = Q_INT64_C(11644473600000000);
+static const char *const FORMAT_DATE = "yyyy-MM-dd";
+static const char *const FORMAT_TIME = "hh:mm:ss";
+static const FunGetSystemTimePreciseAsFileTime g_getSystemTimePrecise = lookupPreciseTime();
+static const char CHANNEL_IDS[32] =
+{
+	'\0', 'O',  'E',  '\0', 'I',  '\0', '\0', '\0', 'S',  '\0', '\0', '\0', '\0', '\0', '\0', '\0',
+	'F',  '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0'
+};
+
+/*
+ * Constructor
+ */
+CLogFormatter::CLogFormatter(void)
+:
+	m_format(LOG_FORMAT_VERBOSE),
+	m_simplify(true),
+	m_preciseTime(false),
+	m_cachedSecond(-1)
+{
+	selectBatchFun();
+}
+
+/*
+ * Filter and format a batch of (already simplified) lines, result is appended to output
+ */
+template<CLogFormatter::Format FORMAT, bool FILTER, bool PRECISE>
+quint32 CLogFormatter::formatBatchT(const CLogFormatter &self, QString &output, const QChar *arena, const line_t *lines, const int count)
+{
+	quint32 records = 0;
+
+	for(const line_t *line = lines; line != (lines + count); line++)
+	{
+		const QChar *const data = arena + line->offset;
+		const int len = line->length;
+
+		//Do not log system messages in plain mode
+		if((FORMAT == LOG_FORMAT_PLAIN) && (line->channel == CHANNEL_SYSMSG))
+		{
+			continue;
+		}
+
+		//Do not log any empty strings!
+		if(len < 1)
+		{
+			continue;
+		}
+
+		//Filter out strings
+		if(FILTER && (line->channel != CHANNEL_SYSMSG) && (!self.acceptLine(data, len)))
+		{
+			continue;
+		}
+
+		const char chanId = CHANNEL_IDS[line->channel & 0x1F];
+		if(!chanId)
+		{
+			throw "Bad selection!";
+		}
+
+		if(FORMAT != LOG_FORMAT_PLAIN)
+		{
+			self.updateTime(line->timeStamp);
+		}
+
+		switch(FORMAT)
+		{
+		case LOG_FORMAT_VERBOSE:
+			output.append(QChar('[')).append(QLatin1Char(chanId)).append(QLatin1String("] ")).append(self.m_cachedPrefix);
+			if(PRECISE) self.appendFraction(output, line->timeStamp);
+			output.append(QLatin1String("] "));
+			output.insert(output.length(), data, len).append(QLatin1String("\r\n"));
+			break;
+		case LOG_FORMAT_PLAIN:
+			output.insert(output.length(), data, len).append(QLatin1String("\r\n"));
+			break;
+		case LOG_FORMAT_HTML:
+			output.append(QLatin1String("<tr><td>")).append(QLatin1Char(chanId)).append(self.m_cachedPrefix);
+			if(PRECISE) self.appendFraction(output, line->timeStamp);
+			output.append(QLatin1String("</td><td>"));
+			escape(output, data, len);
+			output.append(QLatin1String("</td></tr>\r\n"));
+			break;
+		case LOG_FORMAT_JSON:
+			output.append(QLatin1String("{\"channel\":\"")).append(QLatin1Char(chanId)).append(self.m_cachedPrefix);
+			if(PRECISE) self.appendFraction(output, line->timeStamp);
+			output.append(QLatin1String("\",\"text\":\""));
+			escapeJson(output, data, len);
+			output.append(QLatin1String("\"}\r\n"));
+			break;
+		}
+
+		records++;
+	}
+
+	return records;
+}
+
+/*
+ * Format a single line that already is in the output encoding (plain or verbose only)
+ * The output must have room for RAW_PREFIX_MAX + len + 2 bytes, returns the number of bytes written
+ */
+int CLogFormatter::formatRaw(char *output, const char *data, const int len, const int channel, const qint64 timeStamp) const
+{
+	char *pos = output;
+
+	if(m_format == LOG_FORMAT_VERBOSE)
+	{
+		const char chanId = CHANNEL_IDS[channel & 0x1F];
+		if(!chanId)
+		{
+			throw "Bad selection!";
+		}
+
+		updateTime(timeStamp);
+
+		*pos++ = '['; *pos++ = chanId; *pos++ = ']'; *pos++ = ' ';
+		memcpy(pos, m_cachedPrefixRaw.constData(), m_cachedPrefixRaw.size());
+		pos += m_cachedPrefixRaw.size();
+
+		if(m_preciseTime)
+		{
+			*pos++ = '.';
+			for(int i = 5, value = int(timeStamp % 1000000); i >= 0; i--, value /= 10)
+			{
+				pos[i] = char('0' + (value % 10));
+			}
+			pos += 6;
+		}
+
+		*pos++ = ']'; *pos++ = ' ';
+	}
+
+	memcpy(pos, data, len);
+	pos += len;
+	*pos++ = '\r'; *pos++ = '\n';
+
+	return int(pos - output);
+}
+
+/*
+ * Lines can be written as raw bytes, only if they are neither modified, filtered nor escaped
+ */
+bool CLogFormatter::isRawCapable(void) const
+{
+	return (!m_simplify) && m_regExpKeep.isEmpty() && m_regExpSkip.isEmpty() && ((m_format == LOG_FORMAT_PLAIN) || (m_format == LOG_FORMAT_VERBOSE));
+}
+
+/*
+ * Select the specialized batch function for the current settings
+ */
+void CLogFormatter::selectBatchFun(void)
+{
+#define SPECIALIZATIONS(F) \
+	{ \
+		{ &formatBatchT<F, false, false>, &formatBatchT<F, false, true> }, \
+		{ &formatBatchT<F, true,  false>, &formatBatchT<F, true,  true> }  \
+	}
+
+	static const BatchFun table[4][2][2] =
+	{
+		SPECIALIZATIONS(LOG_FORMAT_PLAIN),
+		SPECIALIZATIONS(LOG_FORMAT_VERBOSE),
+		SPECIALIZATIONS(LOG_FORMAT_HTML),
+		SPECIALIZATIONS(LOG_FORMAT_JSON)
+	};
+
+#undef SPECIALIZATIONS
+
+	if((m_format < LOG_FORMAT_PLAIN) || (m_format > LOG_FORMAT_JSON))
+	{
+		throw "Bad selection!";
+	}
+
+	const bool filter = (!m_regExpKeep.isEmpty()) || (!m_regExpSkip.isEmpty());
+	m_batchFun = table[m_format][filter ? 1 : 0][m_preciseTime ? 1 : 0];
+}
+
+/*
+ * Check line against the keep and skip expressions
+ */
+bool CLogFormatter::acceptLine(const QChar *data, const int len) const
+{
+	m_view.setRawData(data, len);
+	if(!m_regExpKeep.isEmpty())
+	{
+		if(m_regExpKeep.indexIn(m_view) < 0) return false;
+	}
+	if(!m_regExpSkip.isEmpty())
+	{
+		if(m_regExpSkip.indexIn(m_view) >= 0) return false;
+	}
+	return true;
+}
+
+/*
+ * Trim and collapse whitespace in-place (same result as QString::simplified), returns new length
+ * The SIMD kernel can be disabled to compare it against the scalar code
+ */
+int CLogFormatter::simplify(QChar *data, const int len, const bool allowSIMD)
+{
+	int out = 0, i = 0;
+	bool pendingSpace = false;
+
+#ifdef HAVE_SSE2_KERNEL
+	if(g_useSSE2 && allowSIMD)
+	{
+		const __m128i maskNonAscii = _mm_set1_epi16(short(0xFF80));
+		const __m128i valueSpace = _mm_set1_epi16(0x20);
+		const __m128i valueLower = _mm_set1_epi16(0x08);
+		const __m128i valueUpper = _mm_set1_epi16(0x0E);
+		const __m128i zero = _mm_setzero_si128();
+
+		//Process 8 UTF-16 units at a time, anything that might be whitespace is handled by the scalar code
+		while(i + 8 <= len)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+			const __m128i isNonAscii = _mm_andnot_si128(_mm_cmpeq_epi16(_mm_and_si128(v, maskNonAscii), zero), _mm_set1_epi16(-1));
+			const __m128i isCtrlSpace = _mm_and_si128(_mm_cmpgt_epi16(v, valueLower), _mm_cmplt_epi16(v, valueUpper));
+			const __m128i isSpace = _mm_cmpeq_epi16(v, valueSpace);
+			const unsigned long mask = _mm_movemask_epi8(_mm_or_si128(isNonAscii, _mm_or_si128(isCtrlSpace, isSpace)));
+
+			if(mask == 0)
+			{
+				if(pendingSpace)
+				{
+					data[out++] = QChar(' ');
+					pendingSpace = false;
+				}
+				if(out != i)
+				{
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(data + out), v);
+				}
+				out += 8;
+				i += 8;
+				continue;
+			}
+
+			//Copy the leading non-space units, then handle the first candidate
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			const int count = int(index / 2);
+			if(count > 0)
+			{
+				if(pendingSpace)
+				{
+					data[out++] = QChar(' ');
+					pendingSpace = false;
+				}
+				if(out != i)
+				{
+					memmove(data + out, data + i, count * sizeof(QChar));
+				}
+				out += count;
+				i += count;
+			}
+			simplifyStep(data, data[i++], out, pendingSpace);
+		}
+	}
+#endif //HAVE_SSE2_KERNEL
+
+	for(; i < len; i++)
+	{
+		simplifyStep(data, data[i], out, pendingSpace);
+	}
+
+	return out;
+}
+
+/*
+ * Find the next line break (\b, \f, \n, \r or \v) in the text
+ */
+int CLogFormatter::indexOfLineBreak(const QChar *data, const int len, const int from)
+{
+	const ushort *text = reinterpret_cast<const ushort*>(data);
+
+	for(int i = from; i < len; i++)
+	{
+		if(isLineBreak(text[i]))
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Set regular expressions for filtering
+ */
+void CLogFormatter::setFilter(const QString &regExpKeep, const QString &regExpSkip)
+{
+	//Empty strings disable the filter (it can be changed when the config is reloaded)
+	m_regExpKeep = regExpKeep.isEmpty() ? QRegExp() : QRegExp(regExpKeep);
+	m_regExpSkip = regExpSkip.isEmpty() ? QRegExp() : QRegExp(regExpSkip);
+
+	selectBatchFun();
+}
+
+/*
+ * Set output format
+ */
+void CLogFormatter::setFormat(const Format format)
+{
+	m_format = format;
+	m_cachedSecond = -1;
+	selectBatchFun();
+}
+
+/*
+ * Set whether time stamps include microseconds
+ */
+void CLogFormatter::setPreciseTime(const bool preciseTime)
+{
+	m_preciseTime = preciseTime;
+	selectBatchFun();
+}
+
+/*
+ * Update the cached date and time prefix (only once per second)
+ * Formatters run on worker threads too, so no function-local statics must be used here
+ */
+void CLogFormatter::updateTime(const qint64 timeStamp) const
+{
+	const qint64 second = timeStamp / 1000000;
+	if(second != m_cachedSecond)
+	{
+		const QDateTime time = QDateTime::fromMSecsSinceEpoch(second * 1000);
+		const QString date = time.toString(QLatin1String(FORMAT_DATE)), clock = time.toString(QLatin1String(FORMAT_TIME));
+
+		switch(m_format)
+		{
+		case LOG_FORMAT_VERBOSE:
+			m_cachedPrefix = QString("[%1] [%2").arg(date, clock);
+			break;
+		case LOG_FORMAT_HTML:
+			m_cachedPrefix = QString("</td><td>%1</td><td>%2").arg(date, clock);
+			break;
+		case LOG_FORMAT_JSON:
+			m_cachedPrefix = QString("\",\"time\":\"%1T%2").arg(date, clock);
+			break;
+		default:
+			m_cachedPrefix.clear();
+			break;
+		}
+
+		m_cachedPrefixRaw = m_cachedPrefix.toLatin1();
+		m_cachedSecond = second;
+	}
+}
+
+/*
+ * Append the sub-second part of the time stamp (if enabled)
+ */
+void CLogFormatter::appendFraction(QString &output, const qint64 timeStamp) const
+{
+	if(m_preciseTime)
+	{
+		const int micros = int(timeStamp % 1000000);
+		QChar digits[7];
+		digits[0] = QChar('.');
+		for(int i = 6, value = micros; i > 0; i--, value /= 10)
+		{
+			digits[i] = QChar('0' + (value % 10));
+		}
+		output.insert(output.length(), digits, 7);
+	}
+}
+
+/*
+ * Escape (some) HTML characters, result is appended to output
+ */
+void CLogFormatter::escape(QString &output, const QChar *data, const int len)
+{
+	for(int i = 0; i < len; i++)
+	{
+		switch(data[i].unicode())
+		{
+		case '<':
+			output.append(QLatin1String("&lt;"));
+			break;
+		case '>':
+			output.append(QLatin1String("&gt;"));
+			break;
+		case '&':
+			output.append(QLatin1String("&amp;"));
+			break;
+		case '"':
+			output.append(QLatin1String("&quot;"));
+			break;
+		case ' ':
+			output.append(QLatin1String("&nbsp;"));
+			break;
+		default:
+			output.append(data[i]);
+			break;
+		}
+	}
+}
+
+/*
+ * Escape text for use in a JSON string, result is appended to output
+ */
+void CLogFormatter::escapeJson(QString &output, const QChar *data, const int len)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	for(int i = 0; i < len; i++)
+	{
+		const ushort c = data[i].unicode();
+		switch(c)
+		{
+		case '"':
+			output.append(QLatin1String("\\\""));
+			break;
+		case '\\':
+			output.append(QLatin1String("\\\\"));
+			break;
+		case '\t':
+			output.append(QLatin1String("\\t"));
+			break;
+		default:
+			if(c < 0x20)
+			{
+				output.append(QLatin1String("\\u00")).append(QChar(hex[c >> 4])).append(QChar(hex[c & 0xF]));
+			}
+			else
+			{
+				output.append(data[i]);
+			}
+			break;
+		}
+	}
+}
+
+/*
+ * Current time in microseconds since the epoch (precise, if supported by the OS)
+ */
+qint64 CLogFormatter::currentTime(void)
+{
+	FILETIME fileTime;
+	if(g_getSystemTimePrecise)
+	{
+		g_getSystemTimePrecise(&fileTime);
+	}
+	else
+	{
+		GetSystemTimeAsFileTime(&fileTime);
+	}
+
+	const qint64 ticks = (qint64(fileTime.dwHighDateTime) << 32) | qint64(fileTime.dwLowDateTime);
+	return (ticks / 10) - FILETIME_EPOCH_OFFSET;
+}
+
+// ===================================================
+// Misc Stuff
+// ===================================================
+
+/*
+ * Process a single character for simplification
+ */
+static __forceinline void simplifyStep(QChar *data, const QChar c, int &out, bool &pendingSpace)
+{
+	if(c.isSpace())
+	{
+		pendingSpace = (out > 0);
+		return;
+	}
+	if(pendingSpace)
+	{
+		data[out++] = QChar(' ');
+		pendingSpace = false;
+	}
+	data[out++] = c;
+}
+
+/*
+ * Check whether the CPU supports SSE2 (always the case on x64)
+ */
+static bool detectSSE2(void)
+{
+#if defined(_M_X64)
+	return true;
+#elif defined(_M_IX86)
+	int info[4];
+	__cpuid(info, 1);
+	return ((info[3] & (1 << 26)) != 0);
+#else
+	return false;
+#endif
+}
+
+/*
+ * Look up GetSystemTimePreciseAsFileTime (Windows 8 and later)
+ */
+static FunGetSystemTimePreciseAsFileTime lookupPreciseTime(void)
+{
+	if(HMODULE krnl32 = GetModuleHandleA("Kernel32.dll"))
+	{
+		return (FunGetSystemTimePreciseAsFileTime) GetProcAddress(krnl32, "GetSystemTimePreciseAsFileTime");
+	}
+	return NULL;
+}
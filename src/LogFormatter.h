@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QRegExp>
+
+//Const
+static const int CHANNEL_STDOUT = 1;
+static const int CHANNEL_STDERR = 2;
+static const int CHANNEL_STDINP = 4;
+static const int CHANNEL_SYSMSG = 8;
+static const int CHANNEL_FILE = 16;
+static const int RAW_PREFIX_MAX = 64;
+
+//Single line, the payload is stored in the arena of the batch
+typedef struct
+{
+	int offset;
+	int length;
+	int channel;
+	qint64 timeStamp; //microseconds
+}
+line_t;
+
+//Class CLogFormatter
+//Filters and formats batches of lines; copies can be used concurrently from different threads
+//The format, filter and time stamp choices are resolved into a specialized batch function once, when the settings change
+class CLogFormatter
+{
+public:
+	CLogFormatter(void);
+
+	//Types
+	typedef enum
+	{
+		LOG_FORMAT_PLAIN = 0,
+		LOG_FORMAT_VERBOSE = 1,
+		LOG_FORMAT_HTML = 2,
+		LOG_FORMAT_JSON = 3
+	}
+	Format;
+
+	//Line processing (time stamps are in microseconds since the epoch)
+	quint32 formatBatch(QString &output, const QChar *arena, const line_t *lines, const int count) const { return m_batchFun(*this, output, arena, lines, count); }
+	static int simplify(QChar *data, const int len, const bool allowSIMD = true);
+	static int indexOfLineBreak(const QChar *data, const int len, const int from = 0);
+	static bool isLineBreak(const uint c) { return (c <= 0x0D) && ((c == '\n') || (c == '\r') || (c == '\f') || (c == '\v') || (c == '\b')); }
+	int formatRaw(char *output, const char *data, const int len, const int channel, const qint64 timeStamp) const;
+
+	//Setter methods
+	void setFormat(const Format format);
+	void setSimplify(const bool simplify) { m_simplify = simplify; }
+	void setPreciseTime(const bool preciseTime);
+	void setFilter(const QString &regExpKeep, const QString &regExpSkip);
+
+	//Getter methods
+	Format format(void) const { return m_format; }
+	bool isSimplifyEnabled(void) const { return m_simplify; }
+	bool isPreciseTimeEnabled(void) const { return m_preciseTime; }
+	bool isRawCapable(void) const;
+
+	//Misc
+	static void escape(QString &output, const QChar *data, const int len);
+	static void escapeJson(QString &output, const QChar *data, const int len);
+	static qint64 currentTime(void);
+
+private:
+	typedef quint32 (*BatchFun)(const CLogFormatter &self, QString &output, const QChar *arena, const line_t *lines, const int count);
+
+	template<Format FORMAT, bool FILTER, bool PRECISE>
+	static quint32 formatBatchT(const CLogFormatter &self, QString &output, const QChar *arena, const line_t *lines, const int count);
+
+	void selectBatchFun(void);
+	bool acceptLine(const QChar *data, const int len) const;
+	void updateTime(const qint64 timeStamp) const;
+	void appendFraction(QString &output, const qint64 timeStamp) const;
+
+	BatchFun m_batchFun;
+
+	Format m_format;
+	bool m_simplify;
+	bool m_preciseTime;
+
+	QRegExp m_regExpKeep;
+	QRegExp m_regExpSkip;
+
+	//Scratch data, each thread must use its own copy of the formatter
+	mutable QString m_view;
+	mutable qint64 m_cachedSecond;
+	mutable QString m_cachedPrefix;
+	mutable QByteArray m_cachedPrefixRaw;
+};
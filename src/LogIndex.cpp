@@ -0,0 +1,299 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LogIndex.h"
+
+//Qt
+#include <QFile>
+#include <QDateTime>
+
+//CRT
+#include <cstring>
+
+//Index file layout: header followed by fixed-size entries (little endian)
+static const char INDEX_MAGIC[8] = { 'L', 'U', 'I', 'D', 'X', '\x01', '\0', '\0' };
+
+#pragma pack(push, 1)
+typedef struct
+{
+	qint64 timeStamp;
+	quint64 record;
+	qint64 offset;
+}
+index_entry_t;
+#pragma pack(pop)
+
+//Helper
+#define SAFE_DEL(X) do { if(X) { delete (X); X = NULL; } } while (0)
+
+/*
+ * Constructor
+ */
+CLogIndex::CLogIndex(const QString &logFileName)
+{
+	m_indexFile = new QFile(indexFileName(logFileName));
+}
+
+/*
+ * Destructor
+ */
+CLogIndex::~CLogIndex(void)
+{
+	if(m_indexFile->isOpen())
+	{
+		m_indexFile->close();
+	}
+	SAFE_DEL(m_indexFile);
+}
+
+/*
+ * Open the index file for writing
+ */
+bool CLogIndex::open(const bool truncate)
+{
+	const QIODevice::OpenMode openFlags = (truncate) ? (QIODevice::WriteOnly | QIODevice::Truncate) : QIODevice::Append;
+	if(!m_indexFile->open(openFlags))
+	{
+		return false;
+	}
+
+	//Discard a partial entry that was left over by a previous session
+	const qint64 size = m_indexFile->size();
+	if((size > qint64(sizeof(INDEX_MAGIC))) && (((size - sizeof(INDEX_MAGIC)) % sizeof(index_entry_t)) != 0))
+	{
+		m_indexFile->resize(size - ((size - sizeof(INDEX_MAGIC)) % sizeof(index_entry_t)));
+	}
+
+	if(m_indexFile->size() < qint64(sizeof(INDEX_MAGIC)))
+	{
+		m_indexFile->resize(0);
+		m_indexFile->write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	}
+
+	return true;
+}
+
+/*
+ * Add one entry to the index
+ */
+void CLogIndex::append(const qint64 timeStamp, const quint64 record, const qint64 offset)
+{
+	index_entry_t entry;
+	entry.timeStamp = timeStamp;
+	entry.record = record;
+	entry.offset = offset;
+	m_indexFile->write(reinterpret_cast<const char*>(&entry), sizeof(index_entry_t));
+}
+
+/*
+ * Flush the index entries to the OS
+ */
+void CLogIndex::flush(void)
+{
+	m_indexFile->flush();
+}
+
+// ===================================================
+// Index lookup
+// ===================================================
+
+/*
+ * Extract "yyyy-MM-dd hh:mm:ss" key and channel from a verbose, HTML or JSON log line
+ */
+static bool parseLine(const char *line, const qint64 len, char *key, char &channel)
+{
+	static const char VERBOSE_PREFIX[] = "[?] [yyyy-MM-dd] [hh:mm:ss]";
+	static const char HTML_PREFIX[] = "<tr><td>?</td><td>yyyy-MM-dd</td><td>hh:mm:ss</td>";
+	static const char JSON_PREFIX[] = "{\"channel\":\"?\",\"time\":\"yyyy-MM-ddThh:mm:ss";
+
+	if((len >= qint64(sizeof(VERBOSE_PREFIX) - 1)) && (line[0] == '[') && (line[4] == '[') && (line[17] == '['))
+	{
+		channel = line[1];
+		memcpy(&key[0], &line[5], 10);
+		memcpy(&key[11], &line[18], 8);
+	}
+	else if((len >= qint64(sizeof(HTML_PREFIX) - 1)) && (!strncmp(line, HTML_PREFIX, 8)))
+	{
+		channel = line[8];
+		memcpy(&key[0], &line[18], 10);
+		memcpy(&key[11], &line[37], 8);
+	}
+	else if((len >= qint64(sizeof(JSON_PREFIX) - 1)) && (!strncmp(line, JSON_PREFIX, 12)))
+	{
+		channel = line[12];
+		memcpy(&key[0], &line[23], 10);
+		memcpy(&key[11], &line[34], 8);
+	}
+	else
+	{
+		return false;
+	}
+
+	key[10] = ' ';
+	return true;
+}
+
+/*
+ * Print all lines from the log file that are within the given time window
+ */
+bool CLogIndex::query(const QString &logFileName, const QDateTime &from, const QDateTime &to, const char channel, FILE *output)
+{
+	QFile indexFile(indexFileName(logFileName)), logFile(logFileName);
+
+	if(!(indexFile.open(QIODevice::ReadOnly) && logFile.open(QIODevice::ReadOnly)))
+	{
+		return false;
+	}
+
+	const qint64 indexSize = indexFile.size();
+	const qint64 logSize = logFile.size();
+
+	if(indexSize < qint64(sizeof(INDEX_MAGIC)))
+	{
+		return false;
+	}
+
+	const uchar *indexData = indexFile.map(0, indexSize);
+	if((!indexData) || memcmp(indexData, INDEX_MAGIC, sizeof(INDEX_MAGIC)))
+	{
+		return false;
+	}
+
+	const index_entry_t *entries = reinterpret_cast<const index_entry_t*>(indexData + sizeof(INDEX_MAGIC));
+	const qint64 count = (indexSize - sizeof(INDEX_MAGIC)) / sizeof(index_entry_t);
+
+	//The log has a resolution of one second, so the upper bound is inclusive
+	const qint64 fromMSecs = from.toMSecsSinceEpoch();
+	const qint64 toMSecs = to.toMSecsSinceEpoch() + 999;
+
+	//Binary search for the last entry *before* the time window
+	qint64 lo = 0, hi = count;
+	while(lo < hi)
+	{
+		const qint64 mid = (lo + hi) / 2;
+		if(entries[mid].timeStamp < fromMSecs) lo = mid + 1; else hi = mid;
+	}
+	const qint64 beginOffset = (lo > 0) ? entries[lo - 1].offset : 0;
+
+	//Binary search for the first entry *after* the time window
+	hi = count;
+	while(lo < hi)
+	{
+		const qint64 mid = (lo + hi) / 2;
+		if(entries[mid].timeStamp <= toMSecs) lo = mid + 1; else hi = mid;
+	}
+	const qint64 endOffset = qMin((lo < count) ? entries[lo].offset : logSize, logSize);
+
+	if(endOffset <= beginOffset)
+	{
+		return true;
+	}
+
+	const char *data = reinterpret_cast<const char*>(logFile.map(beginOffset, endOffset - beginOffset));
+	if(!data)
+	{
+		return false;
+	}
+
+	const QByteArray fromKey = from.toString("yyyy-MM-dd hh:mm:ss").toLatin1();
+	const QByteArray toKey = to.toString("yyyy-MM-dd hh:mm:ss").toLatin1();
+
+	const char *const end = data + (endOffset - beginOffset);
+	const char *line = data;
+
+	//Skip the BOM at the very beginning of the file
+	if((beginOffset == 0) && ((end - line) >= 3) && (!memcmp(line, "\xEF\xBB\xBF", 3)))
+	{
+		line += 3;
+	}
+
+	char key[19], chanId;
+	while(line < end)
+	{
+		const char *next = reinterpret_cast<const char*>(memchr(line, '\n', end - line));
+		next = next ? (next + 1) : end;
+
+		if(parseLine(line, next - line, key, chanId))
+		{
+			if((memcmp(key, fromKey.constData(), 19) >= 0) && (memcmp(key, toKey.constData(), 19) <= 0) && ((!channel) || (chanId == channel)))
+			{
+				fwrite(line, 1, next - line, output);
+			}
+		}
+		else if(!channel)
+		{
+			//Plain log lines don't have a time stamp, so the index granularity applies
+			fwrite(line, 1, next - line, output);
+		}
+
+		line = next;
+	}
+
+	fflush(output);
+	return true;
+}
+
+// ===================================================
+// Index repair
+// ===================================================
+
+/*
+ * Drop partial entries and entries that point beyond the end of the log file
+ */
+bool CLogIndex::repair(const QString &logFileName, const qint64 logSize)
+{
+	QFile indexFile(indexFileName(logFileName));
+	if(!indexFile.exists())
+	{
+		return true;
+	}
+	if(!indexFile.open(QIODevice::ReadWrite))
+	{
+		return false;
+	}
+
+	const qint64 size = indexFile.size();
+	if(size < qint64(sizeof(INDEX_MAGIC)))
+	{
+		indexFile.close();
+		return false;
+	}
+
+	//Entries are ordered by offset, so search backwards for the last valid one
+	qint64 count = (size - sizeof(INDEX_MAGIC)) / sizeof(index_entry_t);
+	while(count > 0)
+	{
+		index_entry_t entry;
+		if(!(indexFile.seek(sizeof(INDEX_MAGIC) + ((count - 1) * sizeof(index_entry_t))) && (indexFile.read(reinterpret_cast<char*>(&entry), sizeof(index_entry_t)) == sizeof(index_entry_t))))
+		{
+			break;
+		}
+		if(entry.offset < logSize)
+		{
+			break;
+		}
+		count--;
+	}
+
+	const bool success = indexFile.resize(sizeof(INDEX_MAGIC) + (count * sizeof(index_entry_t)));
+	indexFile.close();
+	return success;
+}
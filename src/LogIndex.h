@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QString>
+#include <cstdio>
+
+//Forward declaration
+class QFile;
+class QDateTime;
+
+//Class CLogIndex
+class CLogIndex
+{
+public:
+	CLogIndex(const QString &logFileName);
+	~CLogIndex(void);
+
+	//Index writing
+	bool open(const bool truncate);
+	void append(const qint64 timeStamp, const quint64 record, const qint64 offset);
+	void flush(void);
+
+	//Index lookup
+	static bool query(const QString &logFileName, const QDateTime &from, const QDateTime &to, const char channel, FILE *output);
+
+	//Index repair
+	static bool repair(const QString &logFileName, const qint64 logSize);
+
+	//Misc
+	static QString indexFileName(const QString &logFileName) { return logFileName + ".idx"; }
+
+private:
+	QFile *m_indexFile;
+};
@@ -0,0 +1,459 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "LogJournal.h"
+
+//Windows
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+//Qt
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QCoreApplication>
+#include <QRegExp>
+
+//Internal
+#include "LogIndex.h"
+
+//CRT
+#include <cstring>
+
+//Journal file layout: fixed-size header followed by the pending data (little endian)
+static const char JOURNAL_MAGIC[8] = { 'L', 'U', 'J', 'N', 'L', '\x01', '\0', '\0' };
+static const int JOURNAL_FOOTER_SIZE = 232;
+static const int JOURNAL_DATA_SIZE = 262144;
+
+#pragma pack(push, 1)
+typedef struct
+{
+	char magic[8];
+	qint64 fileOffset;
+	quint32 dataSize;
+	quint32 footerSize;
+	char footer[JOURNAL_FOOTER_SIZE];
+}
+journal_header_t;
+#pragma pack(pop)
+
+//Left-over journal, locked for exclusive access
+typedef struct
+{
+	QString fileName;
+	HANDLE handle;
+	QByteArray content;
+	qint64 fileOffset;
+}
+orphan_t;
+
+//Helper
+#define SAFE_DEL(X) do { if(X) { delete (X); X = NULL; } } while (0)
+#define HEADER(X) (reinterpret_cast<volatile journal_header_t*>(X))
+
+//Forward declarations
+static HANDLE lockJournal(const QString &fileName);
+static bool readJournal(const HANDLE handle, QByteArray &content);
+static bool parseHeader(const QByteArray &content, journal_header_t &header);
+static bool replayJournal(const QString &logFileName, const QByteArray &content, qint64 &recoveredBytes, qint64 &appendedBytes);
+static bool lessOffset(const orphan_t &a, const orphan_t &b);
+
+/*
+ * Constructor
+ */
+CLogJournal::CLogJournal(const QString &logFileName)
+:
+	m_view(NULL)
+{
+	m_journalFile = new QFile(journalFileName(logFileName));
+}
+
+/*
+ * Destructor (the journal file is kept, unless it has been closed)
+ */
+CLogJournal::~CLogJournal(void)
+{
+	if(m_view)
+	{
+		m_journalFile->unmap(m_view);
+		m_view = NULL;
+	}
+	if(m_journalFile->isOpen())
+	{
+		m_journalFile->close();
+	}
+	SAFE_DEL(m_journalFile);
+}
+
+/*
+ * Create and map the journal file, pending data starts at the given log file offset
+ */
+bool CLogJournal::open(const qint64 fileOffset)
+{
+	const qint64 totalSize = sizeof(journal_header_t) + JOURNAL_DATA_SIZE;
+
+	if(!m_journalFile->open(QIODevice::ReadWrite | QIODevice::Truncate))
+	{
+		return false;
+	}
+
+	if(!m_journalFile->resize(totalSize))
+	{
+		m_journalFile->close();
+		m_journalFile->remove();
+		return false;
+	}
+
+	m_view = m_journalFile->map(0, totalSize);
+	if(!m_view)
+	{
+		m_journalFile->close();
+		m_journalFile->remove();
+		return false;
+	}
+
+	volatile journal_header_t *header = HEADER(m_view);
+	header->fileOffset = fileOffset;
+	header->dataSize = 0;
+	header->footerSize = 0;
+	memcpy(const_cast<char*>(header->magic), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+
+	return true;
+}
+
+/*
+ * Unmap and remove the journal file (all data has been written to the log file)
+ */
+void CLogJournal::close(void)
+{
+	if(m_view)
+	{
+		m_journalFile->unmap(m_view);
+		m_view = NULL;
+	}
+	if(m_journalFile->isOpen())
+	{
+		m_journalFile->close();
+		m_journalFile->remove();
+	}
+}
+
+/*
+ * Append pending data, returns false if the journal is full
+ */
+bool CLogJournal::append(const char *data, const int len)
+{
+	volatile journal_header_t *header = HEADER(m_view);
+	const quint32 dataSize = header->dataSize;
+
+	if((len < 0) || (dataSize + quint32(len) > quint32(JOURNAL_DATA_SIZE)))
+	{
+		return false;
+	}
+
+	//The data must be in place, before the size is updated
+	memcpy(m_view + sizeof(journal_header_t) + dataSize, data, len);
+	header->dataSize = dataSize + len;
+	return true;
+}
+
+/*
+ * Pending data has been written to the log file, which now ends at the given offset
+ */
+void CLogJournal::commit(const qint64 fileOffset)
+{
+	volatile journal_header_t *header = HEADER(m_view);
+	header->dataSize = 0;
+	header->fileOffset = fileOffset;
+}
+
+/*
+ * Set data that is to be appended to the log file on recovery (e.g. HTML footer)
+ */
+void CLogJournal::setFooter(const QByteArray &footer)
+{
+	volatile journal_header_t *header = HEADER(m_view);
+	const int len = qMin(footer.size(), JOURNAL_FOOTER_SIZE);
+
+	header->footerSize = 0;
+	memcpy(const_cast<char*>(header->footer), footer.constData(), len);
+	header->footerSize = len;
+}
+
+/*
+ * Pointer to the pending data
+ */
+const char *CLogJournal::data(void) const
+{
+	return reinterpret_cast<const char*>(m_view + sizeof(journal_header_t));
+}
+
+/*
+ * Size of the pending data
+ */
+int CLogJournal::size(void) const
+{
+	return int(HEADER(m_view)->dataSize);
+}
+
+// ===================================================
+// Recovery
+// ===================================================
+
+/*
+ * Name of the journal file of the current process, each process journals to its own file
+ */
+QString CLogJournal::journalFileName(const QString &logFileName)
+{
+	return QString("%1.%2.jnl").arg(logFileName, QString::number(QCoreApplication::applicationPid()));
+}
+
+/*
+ * Name pattern of the journal files of all processes (for messages)
+ */
+QString CLogJournal::journalFilePattern(const QString &logFileName)
+{
+	return logFileName + ".*.jnl";
+}
+
+/*
+ * All journal files of the given log file, including those of running processes
+ */
+QStringList CLogJournal::findJournals(const QString &logFileName)
+{
+	const QFileInfo logInfo(logFileName);
+	const QDir logDir = logInfo.absoluteDir();
+
+	//The wildcard would also match the journals of "<log>.<suffix>", so only process ids are accepted
+	QStringList journals;
+	const QRegExp pattern(QString("^%1\\.\\d+\\.jnl$").arg(QRegExp::escape(logInfo.fileName())), Qt::CaseInsensitive);
+	const QStringList names = logDir.entryList(QStringList() << QString("%1.*.jnl").arg(logInfo.fileName()), QDir::Files);
+	for(int i = 0; i < names.count(); i++)
+	{
+		if(pattern.exactMatch(names.at(i)))
+		{
+			journals << logDir.absoluteFilePath(names.at(i));
+		}
+	}
+	return journals;
+}
+
+/*
+ * Check whether a journal has been left over for the given log file (journals of running processes are ignored)
+ */
+bool CLogJournal::exists(const QString &logFileName)
+{
+	const QStringList journals = findJournals(logFileName);
+	for(int i = 0; i < journals.count(); i++)
+	{
+		const HANDLE handle = lockJournal(journals.at(i));
+		if(handle != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(handle);
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Check whether a running process is journaling the given log file
+ */
+bool CLogJournal::inUse(const QString &logFileName)
+{
+	const QStringList journals = findJournals(logFileName);
+	for(int i = 0; i < journals.count(); i++)
+	{
+		const HANDLE handle = lockJournal(journals.at(i));
+		if(handle == INVALID_HANDLE_VALUE)
+		{
+			return true;
+		}
+		CloseHandle(handle);
+	}
+	return false;
+}
+
+/*
+ * Replay all left-over journals into the log file, the log file is never truncated
+ * Data that can not be restored at its original position is appended to the end of the log file (counted by appendedBytes)
+ * The owner keeps its journal open, so a journal that can be opened exclusively has no live owner
+ */
+bool CLogJournal::recover(const QString &logFileName, qint64 &recoveredBytes, qint64 &appendedBytes)
+{
+	recoveredBytes = 0;
+	appendedBytes = 0;
+
+	//Lock all orphaned journals, so no other process can recover them at the same time
+	QList<orphan_t> orphans;
+	const QStringList journals = findJournals(logFileName);
+	for(int i = 0; i < journals.count(); i++)
+	{
+		orphan_t orphan;
+		orphan.fileName = journals.at(i);
+		orphan.handle = lockJournal(orphan.fileName);
+		if(orphan.handle == INVALID_HANDLE_VALUE)
+		{
+			continue;
+		}
+
+		journal_header_t header;
+		if(!(readJournal(orphan.handle, orphan.content) && parseHeader(orphan.content, header)))
+		{
+			CloseHandle(orphan.handle);
+			for(int j = 0; j < orphans.count(); j++) CloseHandle(orphans.at(j).handle);
+			return false;
+		}
+
+		orphan.fileOffset = header.fileOffset;
+		orphans << orphan;
+	}
+
+	//Replay in the order of the log file offsets
+	qSort(orphans.begin(), orphans.end(), lessOffset);
+
+	bool success = true;
+	for(int i = 0; i < orphans.count(); i++)
+	{
+		qint64 bytes = 0, appended = 0;
+		if(success && replayJournal(logFileName, orphans.at(i).content, bytes, appended))
+		{
+			recoveredBytes += bytes;
+			appendedBytes += appended;
+			CloseHandle(orphans.at(i).handle);
+			success = QFile::remove(orphans.at(i).fileName);
+			continue;
+		}
+		CloseHandle(orphans.at(i).handle);
+		success = false;
+	}
+
+	return success;
+}
+
+// ===================================================
+// Misc Stuff
+// ===================================================
+
+/*
+ * Open a journal file exclusively, fails while the owning process is still running
+ */
+static HANDLE lockJournal(const QString &fileName)
+{
+	return CreateFileW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(fileName).utf16()), GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+}
+
+/*
+ * Order journals by the log file offset of their pending data
+ */
+static bool lessOffset(const orphan_t &a, const orphan_t &b)
+{
+	return a.fileOffset < b.fileOffset;
+}
+
+/*
+ * Read the complete journal file
+ */
+static bool readJournal(const HANDLE handle, QByteArray &content)
+{
+	LARGE_INTEGER fileSize;
+	if((!GetFileSizeEx(handle, &fileSize)) || (fileSize.QuadPart > Q_INT64_C(0x7FFFFFFF)))
+	{
+		return false;
+	}
+
+	content.resize(int(fileSize.QuadPart));
+	DWORD bytesRead = 0;
+	return (content.isEmpty() || ReadFile(handle, content.data(), DWORD(content.size()), &bytesRead, NULL)) && (int(bytesRead) == content.size());
+}
+
+/*
+ * Validate the header of a journal
+ */
+static bool parseHeader(const QByteArray &content, journal_header_t &header)
+{
+	if(content.size() < int(sizeof(journal_header_t)))
+	{
+		return false;
+	}
+
+	memcpy(&header, content.constData(), sizeof(journal_header_t));
+	return (!memcmp(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC))) && (header.fileOffset >= 0) && (header.dataSize <= quint32(content.size() - sizeof(journal_header_t))) && (header.footerSize <= quint32(JOURNAL_FOOTER_SIZE));
+}
+
+/*
+ * Replay a single journal, the missing part of the pending data is appended to the log file
+ * If the log file does not end within the journaled range (or what is there differs from the journal), it has been
+ * written by another session since, so all pending data is appended without the footer
+ */
+static bool replayJournal(const QString &logFileName, const QByteArray &content, qint64 &recoveredBytes, qint64 &appendedBytes)
+{
+	recoveredBytes = 0;
+	appendedBytes = 0;
+
+	journal_header_t header;
+	if(!parseHeader(content, header))
+	{
+		return false;
+	}
+
+	QFile logFile(logFileName);
+	if(!logFile.open(QIODevice::ReadWrite))
+	{
+		return false;
+	}
+
+	const char *const data = content.constData() + sizeof(journal_header_t);
+	const qint64 originalSize = logFile.size();
+	const qint64 written = originalSize - header.fileOffset;
+
+	//The part that made it into the log file before the crash must match the journal
+	bool inPlace = (written >= 0) && (written <= qint64(header.dataSize));
+	if(inPlace && (written > 0))
+	{
+		inPlace = logFile.seek(header.fileOffset) && (logFile.read(written) == QByteArray::fromRawData(data, int(written)));
+	}
+
+	const qint64 skip = inPlace ? written : 0;
+	bool success = logFile.seek(originalSize);
+	success = success && (logFile.write(data + skip, header.dataSize - skip) == (qint64(header.dataSize) - skip));
+	if(inPlace)
+	{
+		success = success && (logFile.write(header.footer, header.footerSize) == qint64(header.footerSize));
+	}
+	success = success && logFile.flush();
+
+	const qint64 logSize = logFile.size();
+	logFile.close();
+
+	if(!success)
+	{
+		return false;
+	}
+
+	//Index must not point beyond the end of the log file
+	CLogIndex::repair(logFileName, logSize);
+
+	recoveredBytes = qint64(header.dataSize) - skip;
+	appendedBytes = inPlace ? 0 : qint64(header.dataSize);
+	return true;
+}
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+//Forward declaration
+class QFile;
+
+//Class CLogJournal
+//Memory-mapped copy of the data that has not been written to the log file yet, survives a crash of the process
+class CLogJournal
+{
+public:
+	CLogJournal(const QString &logFileName);
+	~CLogJournal(void);
+
+	//Journal writing
+	bool open(const qint64 fileOffset);
+	void close(void);
+	bool append(const char *data, const int len);
+	void commit(const qint64 fileOffset);
+	void setFooter(const QByteArray &footer);
+
+	//Getter methods
+	const char *data(void) const;
+	int size(void) const;
+
+	//Recovery
+	static bool recover(const QString &logFileName, qint64 &recoveredBytes, qint64 &appendedBytes);
+
+	//Misc
+	static QString journalFileName(const QString &logFileName);
+	static QString journalFilePattern(const QString &logFileName);
+	static bool exists(const QString &logFileName);
+	static bool inUse(const QString &logFileName);
+
+private:
+	static QStringList findJournals(const QString &logFileName);
+
+	QFile *m_journalFile;
+	uchar *m_view;
+};
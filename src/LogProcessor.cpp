@@ -26,26 +26,59 @@
 #include <Windows.h>
 
 //Qt
-#include <QProcess>
-#include <QTextStream>
 #include <QTextCodec>
 #include <QFile>
-#include <QDateTime>
 #include <QCoreApplication>
 #include <QTimer>
+#include <QDir>
+#include <QFileInfo>
+#include <QtConcurrentRun>
+#include <QFutureWatcher>
+#include <QThreadPool>
 
 //Internal
 #include "InputReader.h"
+#include "FileFollower.h"
+#include "ChildProcess.h"
+#include "LogWriter.h"
+#include "LineBatch.h"
+#include "RateLimiter.h"
+#include "SeverityClassifier.h"
+#include "LogSink.h"
+#include "ProcessMonitor.h"
+#include "ValueExtractor.h"
+#include "ConfigFile.h"
+#include "BinaryFilter.h"
+#include "LatencyTracer.h"
 
 //Const
-static const int CHANNEL_STDOUT = 1;
-static const int CHANNEL_STDERR = 2;
-static const int CHANNEL_STDINP = 4;
-static const int CHANNEL_SYSMSG = 8;
+static const qint64 FILE_WINDOW_SIZE = 64 << 20;
+static const qint64 FILE_CHUNK_SIZE = 1 << 20;
+static const int BATCH_SIZE = 1024;
+static const int SINK_ROTATE_KEEP = 5;
+static const int BUFFER_SIZE = 4096;
+static const int DETECT_SIZE = 64;
+static const char *HTML_FOOTER = "</table></body></html>\r\n";
+static const int INPUT_CHANNELS[] = { CHANNEL_STDOUT, CHANNEL_STDERR, CHANNEL_STDINP, CHANNEL_FILE };
+static const int CHANNEL_INDEX[32] =
+{
+	-1,  0,  1, -1,  2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
 
 //Helper
 #define SAFE_DEL(X) do { if(X) { delete (X); X = NULL; } } while (0)
 
+//Forward declarations
+static CLineBatch *processChunk(const CLogFormatter &formatter, QTextCodec *codec, const char *data, const int len, CLineBatch *batch);
+static CLineBatch *processChunkRaw(const CLogFormatter &formatter, const char *data, const int len, CLineBatch *batch);
+static QTextCodec *detectCodec(const char *data, const int len, QTextCodec *fallback);
+static bool isAsciiCompatible(QTextCodec *codec);
+static int lengthOfBom(const char *data, const int len);
+static int lengthOfHead(const char *data, const int len);
+static CLineBatch *processBatch(const CLogFormatter &formatter, CLineBatch *batch);
+static void writeBatch(CLogWriter *logFile, const CLineBatch *batch, CLatencyTracer *tracer);
+
 // ===================================================
 // Constructor & Destructor
 // ===================================================
@@ -53,15 +86,37 @@ static const int CHANNEL_SYSMSG = 8;
 /*
  * Constructor
  */
-CLogProcessor::CLogProcessor(QFile &logFile)
+CLogProcessor::CLogProcessor(QFile &logFile, void *inputHandle)
 :
+	m_process(NULL),
+	m_stdinReader(NULL),
+	m_follower(NULL),
+	m_inputHandle(inputHandle),
+	m_maxRam(0),
+	m_maxSpill(0),
+	m_inputFile(NULL),
 	m_logStdout(true),
 	m_logStderr(true),
-	m_simplify(true),
-	m_logFormat(LOG_FORMAT_VERBOSE),
+	m_echo(true),
+	m_logIsEmpty(logFile.size() == 0),
+	m_rateLimiter(NULL),
+	m_classifier(NULL),
+	m_extractor(NULL),
+	m_config(NULL),
+	m_sinkFlushOffset(0),
+	m_threadCount(0),
+	m_passthrough(0),
+	m_binaryCheck(0),
+	m_binaryFilter(NULL),
+	m_maxLineLength(0),
+	m_ptyColumns(0),
+	m_ptyRows(0),
+	m_tracer(NULL),
+	m_monitor(NULL),
+	m_statsTimer(NULL),
+	m_statsInterval(-1),
 	m_logInitialized(false),
 	m_logFinished(false),
-	m_logIsEmpty(logFile.size() == 0),
 	m_exitCode(-1)
 {
 	//Sanity check
@@ -70,37 +125,30 @@ CLogProcessor::CLogProcessor(QFile &logFile)
 		throw "Log file not open for writing!";
 	}
 
-	//Create process
-	m_process = new QProcess();
-	
-	//Setup process
-	m_process->setProcessChannelMode(QProcess::SeparateChannels);
-	connect(m_process, SIGNAL(readyReadStandardOutput()), this, SLOT(readFromStdout()));
-	connect(m_process, SIGNAL(readyReadStandardError()), this, SLOT(readFromStderr()));
-	connect(m_process, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(processFinished(int)));
-
-	//Setup STDIN reader
-	m_stdinReader = new CInputReader();
-	connect(m_stdinReader, SIGNAL(dataAvailable(quint32)), this, SLOT(readFromStdinp(void)), Qt::QueuedConnection);
-	connect(m_stdinReader, SIGNAL(finished()), this, SLOT(readerFinished(void)), Qt::QueuedConnection);
-
-	//Create default decoder
-	QTextCodec *codec = QTextCodec::codecForName("UTF-8");
-	m_codecStdout = new QTextDecoder(codec);
-	m_codecStderr = new QTextDecoder(codec);
-	m_codecStdinp = new QTextDecoder(codec);
-
-	//Setup regular exporession
-	m_regExpEOL = new QRegExp("(\\f|\\n|\\r|\\v)");
-	m_regExpKeep = m_regExpSkip = NULL;
+	//Default codec, the process, the STDIN reader and the decoders are created on demand
+	m_codecInput = QTextCodec::codecForName("UTF-8");
+	for(int i = 0; i < CHANNEL_COUNT; i++)
+	{
+		m_channels[i].decoder = NULL;
+		m_channels[i].codec = NULL;
+	}
+
+	//Setup line formatter
+	m_formatter = new CLogFormatter();
+
+	//Setup line storage, buffers are re-used for all data
+	m_batch = new CLineBatch();
+	m_bufferDecode.reserve(BUFFER_SIZE);
 
 	//Assign the log file
-	m_logFile = new QTextStream(&logFile);
-	m_logFile->setCodec(QTextCodec::codecForName("UTF-8"));
-	m_logFile->setGenerateByteOrderMark(m_logIsEmpty);
+	m_logFile = new CLogWriter(logFile, m_logIsEmpty);
 	
 	//Create event loop
 	m_eventLoop = new QEventLoop();
+
+	//Setup timer for interval syncs
+	m_syncTimer = new QTimer();
+	connect(m_syncTimer, SIGNAL(timeout()), this, SLOT(syncLog()));
 }
 
 /*
@@ -110,18 +158,38 @@ CLogProcessor::~CLogProcessor(void)
 {
 	//Make sure, we are not still running
 	forceQuit(true);
+	waitBatches();
 
 	//Clean up all heap objects
 	SAFE_DEL(m_process);
 	SAFE_DEL(m_stdinReader);
-	SAFE_DEL(m_regExpEOL);
-	SAFE_DEL(m_regExpKeep);
-	SAFE_DEL(m_regExpSkip);
+	SAFE_DEL(m_follower);
+	SAFE_DEL(m_inputFile);
+	SAFE_DEL(m_formatter);
 	SAFE_DEL(m_eventLoop);
+	SAFE_DEL(m_syncTimer);
+	SAFE_DEL(m_statsTimer);
+	SAFE_DEL(m_monitor);
 	SAFE_DEL(m_logFile);
-	SAFE_DEL(m_codecStdout);
-	SAFE_DEL(m_codecStderr);
-	SAFE_DEL(m_codecStdinp);
+	for(int i = 0; i < CHANNEL_COUNT; i++)
+	{
+		SAFE_DEL(m_channels[i].decoder);
+	}
+	SAFE_DEL(m_batch);
+	SAFE_DEL(m_rateLimiter);
+	SAFE_DEL(m_classifier);
+	SAFE_DEL(m_extractor);
+	SAFE_DEL(m_config);
+	SAFE_DEL(m_binaryFilter);
+	SAFE_DEL(m_tracer);
+
+	//Close the sinks
+	qDeleteAll(m_sinks);
+	m_sinks.clear();
+
+	//Release the re-usable batches
+	qDeleteAll(m_freeBatches);
+	m_freeBatches.clear();
 }
 
 // ===================================================
@@ -133,24 +201,55 @@ CLogProcessor::~CLogProcessor(void)
  */
 bool CLogProcessor::startProcess(const QString &program, const QStringList &arguments)
 {
-	if(m_process->state() != QProcess::NotRunning)
+	if(m_process && m_process->isRunning())
 	{
 		return false;
 	}
 
+	if(!m_process)
+	{
+		m_process = new CChildProcess();
+		connect(m_process, SIGNAL(readyReadStdout()), this, SLOT(readFromStdout()));
+		connect(m_process, SIGNAL(readyReadStderr()), this, SLOT(readFromStderr()));
+		connect(m_process, SIGNAL(finished(int)), this, SLOT(processFinished(int)));
+	}
+
+	m_process->setPseudoConsole(m_ptyColumns, m_ptyRows);
+
+	//Only the captured channels need a line buffer
+	if(m_logStdout) channelState(CHANNEL_STDOUT).buffer.reserve(BUFFER_SIZE);
+	if(m_logStderr) channelState(CHANNEL_STDERR).buffer.reserve(BUFFER_SIZE);
+
 	initializeLog();
 	logString(QString("Creating new process: %1 [%2]").arg(program, arguments.join("; ")), CHANNEL_SYSMSG);
 	
-	m_process->start(program, arguments);
-
-	if(!m_process->waitForStarted())
+	if(!m_process->start(program, arguments))
 	{
 		logString(QString("Process creation failed: %1").arg(m_process->errorString()) , CHANNEL_SYSMSG);
-		m_process->kill();
 		return false;
 	}
 
-	logString(QString().sprintf("Process created successfully (PID: 0x%08X)", m_process->pid()->hProcess), CHANNEL_SYSMSG);
+	logString(QString().sprintf("Process created successfully (PID: 0x%08X)", m_process->processId()), CHANNEL_SYSMSG);
+
+	if(m_ptyColumns > 0)
+	{
+		logString(QString().sprintf("Process runs on a pseudo console (%dx%d), STDERR is merged into STDOUT", m_ptyColumns, m_ptyRows), CHANNEL_SYSMSG);
+	}
+
+	//Sample the resource usage of the process, if enabled
+	SAFE_DEL(m_statsTimer);
+	SAFE_DEL(m_monitor);
+	if(m_statsInterval >= 0)
+	{
+		m_monitor = new CProcessMonitor(m_process->processHandle());
+		if(m_statsInterval > 0)
+		{
+			m_statsTimer = new QTimer();
+			connect(m_statsTimer, SIGNAL(timeout()), this, SLOT(sampleProcess()));
+			m_statsTimer->start(int(qMin(m_statsInterval, Q_INT64_C(0x7FFFFFFF))));
+		}
+	}
+
 	return true;
 }
 
@@ -159,11 +258,21 @@ bool CLogProcessor::startProcess(const QString &program, const QStringList &argu
  */
 bool  CLogProcessor::startStdinProcessing(void)
 {
-	if(m_stdinReader->isRunning())
+	if(m_stdinReader && m_stdinReader->isRunning())
 	{
 		return false;
 	}
 
+	if(!m_stdinReader)
+	{
+		m_stdinReader = new CInputReader(m_inputHandle);
+		m_stdinReader->setBufferLimits(m_maxRam, m_maxSpill);
+		connect(m_stdinReader, SIGNAL(dataAvailable(quint32)), this, SLOT(readFromStdinp(void)), Qt::QueuedConnection);
+		connect(m_stdinReader, SIGNAL(finished()), this, SLOT(readerFinished(void)), Qt::QueuedConnection);
+	}
+
+	channelState(CHANNEL_STDINP).buffer.reserve(BUFFER_SIZE);
+
 	initializeLog();
 	logString("Started logging from STDIN stream...", CHANNEL_SYSMSG);
 
@@ -171,17 +280,79 @@ bool  CLogProcessor::startStdinProcessing(void)
 	return true;
 }
 
+/*
+ * Start (offline) processing of an existing file
+ */
+bool CLogProcessor::startFileProcessing(const QString &fileName)
+{
+	if(m_inputFile)
+	{
+		return false;
+	}
+
+	m_inputFile = new QFile(fileName);
+	if(!m_inputFile->open(QIODevice::ReadOnly))
+	{
+		SAFE_DEL(m_inputFile);
+		return false;
+	}
+
+	initializeLog();
+	logString(QString("Started processing of file: %1").arg(QDir::toNativeSeparators(fileName)), CHANNEL_SYSMSG);
+	return true;
+}
+
+/*
+ * Start following a file that is written by another program (new data only)
+ */
+bool CLogProcessor::startFileFollowing(const QString &fileName)
+{
+	if(m_follower && m_follower->isRunning())
+	{
+		return false;
+	}
+
+	if(!QFileInfo(fileName).isFile())
+	{
+		return false;
+	}
+
+	if(!m_follower)
+	{
+		m_follower = new CFileFollower(fileName);
+		m_follower->setBufferLimits(m_maxRam, m_maxSpill);
+		connect(m_follower, SIGNAL(dataAvailable(quint32)), this, SLOT(readFromFile(void)), Qt::QueuedConnection);
+		connect(m_follower, SIGNAL(followEvent(QString)), this, SLOT(followerEvent(QString)), Qt::QueuedConnection);
+		connect(m_follower, SIGNAL(finished()), this, SLOT(followerFinished(void)), Qt::QueuedConnection);
+	}
+
+	channelState(CHANNEL_FILE).buffer.reserve(BUFFER_SIZE);
+
+	initializeLog();
+	logString(QString("Started following file: %1").arg(QDir::toNativeSeparators(fileName)), CHANNEL_SYSMSG);
+
+	m_follower->start();
+	return true;
+}
+
 /*
  * Event processing
  */
 int CLogProcessor::exec(void)
 {
-	if(m_process->state() == QProcess::Running || m_stdinReader->isRunning())
+	if(m_inputFile)
+	{
+		//Files are processed in parallel, no events required
+		return processFile();
+	}
+
+	if((m_process && m_process->isRunning()) || (m_stdinReader && m_stdinReader->isRunning()) || (m_follower && m_follower->isRunning()))
 	{
 		//Make sure we will read immediately
 		QTimer::singleShot(0, this, SLOT(readFromStdout()));
 		QTimer::singleShot(0, this, SLOT(readFromStderr()));
 		QTimer::singleShot(0, this, SLOT(readFromStdinp()));
+		QTimer::singleShot(0, this, SLOT(readFromFile()));
 
 		//Event processing
 		return m_eventLoop->exec();
@@ -192,6 +363,7 @@ int CLogProcessor::exec(void)
 		readFromStdout();
 		readFromStderr();
 		readFromStdinp();
+		readFromFile();
 
 		//Flush buffer contents
 		flushBuffers();
@@ -216,12 +388,8 @@ void CLogProcessor::forceQuit(const bool silent)
 	
 	if(m_process)
 	{
-		if(m_process->state() != QProcess::NotRunning)
+		if(m_process->isRunning())
 		{
-			if(m_process->state() == QProcess::Starting)
-			{
-				m_process->waitForStarted();
-			}
 			m_process->kill();
 			m_process->waitForFinished();
 		}
@@ -239,6 +407,19 @@ void CLogProcessor::forceQuit(const bool silent)
 			}
 		}
 	}
+
+	if(m_follower)
+	{
+		if(m_follower->isRunning())
+		{
+			m_follower->abort();
+			if(!m_follower->wait(5000))
+			{
+				m_follower->terminate();
+				m_follower->wait();
+			}
+		}
+	}
 }
 
 /*
@@ -246,12 +427,24 @@ void CLogProcessor::forceQuit(const bool silent)
  */
 void CLogProcessor::readFromStdout(void)
 {
-	const QByteArray data = m_process->readAllStandardOutput();
+	if(!m_process)
+	{
+		return;
+	}
+
+	TRACE_CHUNK(m_tracer, CHANNEL_STDOUT);
+	TRACE_STAGE(m_tracer, "read", 0);
+
+	QByteArray data;
+	m_process->readStdout(data);
 
 	if(data.length() > 0)
 	{
-		fwrite(data.constData(), 1, data.length(), stdout);
-		fflush(stdout);
+		if(m_echo)
+		{
+			fwrite(data.constData(), 1, data.length(), stdout);
+			fflush(stdout);
+		}
 		if(m_logStdout) processData(data, CHANNEL_STDOUT);
 	}
 }
@@ -261,12 +454,24 @@ void CLogProcessor::readFromStdout(void)
  */
 void CLogProcessor::readFromStderr(void)
 {
-	const QByteArray data = m_process->readAllStandardError();
+	if(!m_process)
+	{
+		return;
+	}
+
+	TRACE_CHUNK(m_tracer, CHANNEL_STDERR);
+	TRACE_STAGE(m_tracer, "read", 0);
+
+	QByteArray data;
+	m_process->readStderr(data);
 
 	if(data.length() > 0)
 	{
-		fwrite(data.constData(), 1, data.length(), stderr);
-		fflush(stderr);
+		if(m_echo)
+		{
+			fwrite(data.constData(), 1, data.length(), stderr);
+			fflush(stderr);
+		}
 		if(m_logStderr) processData(data, CHANNEL_STDERR);
 	}
 }
@@ -276,25 +481,55 @@ void CLogProcessor::readFromStderr(void)
  */
 void CLogProcessor::readFromStdinp(void)
 {
+	if(!m_stdinReader)
+	{
+		return;
+	}
+
+	TRACE_CHUNK(m_tracer, CHANNEL_STDINP);
+	TRACE_STAGE(m_tracer, "read", 0);
+
 	QByteArray data;
 	m_stdinReader->readAllData(data);
 
 	if(data.length() > 0)
 	{
-		fwrite(data.constData(), 1, data.length(), stderr);
-		fflush(stderr);
+		if(m_echo)
+		{
+			fwrite(data.constData(), 1, data.length(), stderr);
+			fflush(stderr);
+		}
 		processData(data, CHANNEL_STDINP);
 	}
 }
 
+/*
+ * Read from followed file
+ */
+void CLogProcessor::readFromFile(void)
+{
+	if(!m_follower)
+	{
+		return;
+	}
+
+	TRACE_CHUNK(m_tracer, CHANNEL_FILE);
+	TRACE_STAGE(m_tracer, "read", 0);
+
+	QByteArray data;
+	m_follower->readAllData(data);
+
+	if(data.length() > 0)
+	{
+		processData(data, CHANNEL_FILE);
+	}
+}
+
 /*
  * Process has finished
  */
 void CLogProcessor::processFinished(int exitCode)
 {
-	//Just to be sure (?)
-	m_process->waitForFinished();
-	
 	//Process pending outputs
 	readFromStdout();
 	readFromStderr();
@@ -305,9 +540,17 @@ void CLogProcessor::processFinished(int exitCode)
 	//Now return the exit code
 	m_exitCode = exitCode;
 	logString(QString().sprintf("Process has terminated (exit code: 0x%08X)", exitCode), CHANNEL_SYSMSG);
+
+	if(m_monitor)
+	{
+		if(m_statsTimer) m_statsTimer->stop();
+		logString(m_monitor->totals(), CHANNEL_SYSMSG);
+	}
+
 	finishLog();
 
 	m_eventLoop->exit(m_exitCode);
+	emit finished(m_exitCode);
 }
 
 /*
@@ -315,261 +558,1191 @@ void CLogProcessor::processFinished(int exitCode)
  */
 void CLogProcessor::readerFinished(void)
 {
-	//Process pending outputs
-	readFromStdinp();
+	//Process pending outputs (including data that has been spilled to disk)
+	do
+	{
+		readFromStdinp();
+	}
+	while(m_stdinReader->pendingBytes() > 0);
 
 	//Flush buffer contents
 	flushBuffers();
 
+	if(const quint64 droppedBytes = m_stdinReader->droppedBytes())
+	{
+		logString(QString("Input buffers have overflowed, %1 bytes of data have been dropped!").arg(droppedBytes), CHANNEL_SYSMSG);
+	}
+
 	//Now return the exit code
 	logString("No more data available from STDIN (process has terminated)", CHANNEL_SYSMSG);
 	finishLog();
 
 	m_eventLoop->exit(0);
+	emit finished(0);
 }
 
-// ===================================================
-// Private Methods
-// ===================================================
-
 /*
- * FLush any pending data from buffer
+ * File follower has finished (it was aborted, or the file could not be opened)
  */
-void CLogProcessor::flushBuffers(void)
+void CLogProcessor::followerFinished(void)
 {
-	if(m_logStdout && (!m_bufferStdout.isEmpty()))
+	//Process pending outputs (including data that has been spilled to disk)
+	do
 	{
-		logString(m_simplify ? m_bufferStdout.simplified() : m_bufferStdout, CHANNEL_STDOUT);
-		m_bufferStdout.clear();
+		readFromFile();
 	}
+	while(m_follower->pendingBytes() > 0);
 
-	if(m_logStderr && (!m_bufferStderr.isEmpty()))
-	{
-		logString(m_simplify ? m_bufferStderr.simplified() : m_bufferStderr, CHANNEL_STDERR);
-		m_bufferStderr.clear();
-	}
+	//Flush buffer contents
+	flushBuffers();
 
-	if(!m_bufferStdinp.isEmpty())
+	if(const quint64 droppedBytes = m_follower->droppedBytes())
 	{
-		logString(m_simplify ? m_bufferStdinp.simplified() : m_bufferStdinp, CHANNEL_STDOUT);
-		m_bufferStdinp.clear();
+		logString(QString("Input buffers have overflowed, %1 bytes of data have been dropped!").arg(droppedBytes), CHANNEL_SYSMSG);
 	}
+
+	logString("Stopped following the file", CHANNEL_SYSMSG);
+	finishLog();
+
+	m_eventLoop->exit(0);
+	emit finished(0);
 }
 
 /*
- * Process data (decode and tokenize)
+ * Truncation or rotation of the followed file
  */
-void CLogProcessor::processData(const QByteArray &data, const int channel)
+void CLogProcessor::followerEvent(const QString &message)
 {
-	QString *buffer = NULL;
-	QTextDecoder *decoder = NULL;
-	
-	switch(channel)
-	{
-	case CHANNEL_STDOUT:
-		buffer = &m_bufferStdout;
-		decoder = m_codecStdout;
-		break;
-	case CHANNEL_STDERR:
-		buffer = &m_bufferStderr;
-		decoder = m_codecStderr;
-		break;
-	case CHANNEL_STDINP:
-		buffer = &m_bufferStdinp;
-		decoder = m_codecStdinp;
-		break;
-	default:
-		throw "Bad selection!";
-	}
-
-	buffer->append(decoder->toUnicode(data).replace(QChar('\b'), QChar('\r')));
-
-	int pos = m_regExpEOL->indexIn(*buffer);
-	while(pos >= 0)
-	{
-		if(pos > 0)
-		{
-			logString(m_simplify ? buffer->left(pos).simplified() : buffer->left(pos), channel);
-		}
-		buffer->remove(0, pos + 1);
-		pos = m_regExpEOL->indexIn(*buffer);
-	}
+	//Lines that were read before the event go first
+	readFromFile();
+	logString(message, CHANNEL_SYSMSG);
 }
 
 /*
- * Append string to log file
+ * Write completed batches, in original order
  */
-void CLogProcessor::logString(const QString &data, const int channel)
+void CLogProcessor::writeBatches(void)
 {
-	//No logging if not ready
-	if((!m_logInitialized) || m_logFinished)
+	while((!m_pendingBatches.isEmpty()) && m_pendingBatches.first()->isFinished())
 	{
-		return;
+		QFutureWatcher<CLineBatch*> *watcher = m_pendingBatches.takeFirst();
+		CLineBatch *batch = watcher->result();
+		writeBatch(m_logFile, batch, m_tracer);
+		routeBatch(batch);
+		recycleBatch(batch);
+		watcher->deleteLater();
 	}
+}
 
-	//Do not log any empty strings!
-	if(data.isEmpty() || ((m_logFormat == LOG_FORMAT_PLAIN) && (channel == CHANNEL_SYSMSG)))
-	{
-		return;
-	}
-	
-	//Filter out strings
-	if(channel != CHANNEL_SYSMSG)
+/*
+ * Periodic sync of the log file (interval durability)
+ */
+void CLogProcessor::syncLog(void)
+{
+	if(m_logInitialized && (!m_logFinished))
 	{
-		if(m_regExpKeep)
-		{
-			if(m_regExpKeep->indexIn(data) < 0) return;
-		}
-		if(m_regExpSkip)
+		m_logFile->commit();
+		for(int i = 0; i < m_sinks.count(); i++)
 		{
-			if(m_regExpSkip->indexIn(data) >= 0) return;
+			m_sinks.at(i)->flush();
 		}
 	}
+}
 
-	QChar chanId;
-
-	switch(channel)
+/*
+ * Log the errors of the sinks as system messages
+ */
+void CLogProcessor::reportSinkErrors(void)
+{
+	for(int i = 0; i < m_sinks.count(); i++)
 	{
-	case CHANNEL_STDOUT:
-		chanId = 'O';
-		break;
-	case CHANNEL_STDERR:
-		chanId = 'E';
-		break;
-	case CHANNEL_STDINP:
-		chanId = 'I';
-		break;
-	case CHANNEL_SYSMSG:
-		chanId = 'S';
-		break;
-	default:
-		throw "Bad selection!";
+		if(m_sinks.at(i)->hasError())
+		{
+			logString(m_sinks.at(i)->takeError(), CHANNEL_SYSMSG);
+		}
 	}
+}
 
-	static const QString format_date("yyyy-MM-dd"), format_time("hh:mm:ss");
-	QDateTime time = (m_logFormat == LOG_FORMAT_PLAIN) ? QDateTime() : QDateTime::currentDateTime();
-
-	switch(m_logFormat)
+/*
+ * Periodic sample of the resource usage of the process
+ */
+void CLogProcessor::sampleProcess(void)
+{
+	if(m_monitor && m_logInitialized && (!m_logFinished))
 	{
-	case LOG_FORMAT_VERBOSE:
-		m_logFile->operator<<(QString("[%1] [%2] [%3] %4\r\n").arg(chanId, time.toString(format_date), time.toString(format_time), data));
-		break;
-	case LOG_FORMAT_PLAIN:
-		m_logFile->operator<<(QString("%1\r\n").arg(data));
-		break;
-	case LOG_FORMAT_HTML:
-		m_logFile->operator<<(QString("<tr><td>%1</td><td>%2</td><td>%3</td><td>%4</td></tr>\r\n").arg(chanId, time.toString(format_date), time.toString(format_time), escape(data)));
-		break;
-	default:
-		throw "Bad selection!";
+		const QString statistics = m_monitor->sample();
+		if(!statistics.isEmpty())
+		{
+			logString(statistics, CHANNEL_SYSMSG);
+		}
 	}
 }
 
 /*
- * Initialize log file
+ * Config file has changed, the new filter and format options take effect between two batches
  */
-void CLogProcessor::initializeLog(void)
+void CLogProcessor::reloadConfig(void)
 {
-	if(m_logInitialized)
+	if((!m_config) || (!m_logInitialized) || m_logFinished)
 	{
 		return;
 	}
 
-	if((m_logFormat == LOG_FORMAT_HTML) && m_logIsEmpty)
-	{
-		m_logFile->operator<<("<!DOCTYPE html>\r\n");
-		m_logFile->operator<<("<html><head><title>Log File</title></head><body><table style=\"font-family:monospace\" border>\r\n");
-		m_logFile->operator<<("<tr><td>&nbsp;</td><td><b>Date</b></td><td><b>Time</b></td><td><b>Log Message</b></td></tr>\r\n");
-	}
-	if((m_logFormat == LOG_FORMAT_VERBOSE) && (!m_logIsEmpty))
+	CLogFormatter formatter(*m_formatter);
+	if(!(m_config->load() && m_config->applyTo(formatter)))
 	{
-		m_logFile->operator<<("---------------------------\r\n");
+		logString(QString("Failed to reload the config file, keeping the current settings: %1").arg(QDir::toNativeSeparators(m_config->fileName())), CHANNEL_SYSMSG);
+		return;
 	}
 
-	m_logInitialized = true;
-}
-
-/*
- * Finish log file
- */
-void CLogProcessor::finishLog(void)
-{
-	if((!m_logInitialized) || m_logFinished)
+	//The HTML header and footer are written only once
+	if((formatter.format() == CLogFormatter::LOG_FORMAT_HTML) != (m_formatter->format() == CLogFormatter::LOG_FORMAT_HTML))
 	{
+		logString("The config file can not switch from or to HTML output, keeping the current settings", CHANNEL_SYSMSG);
 		return;
 	}
 
-	if((m_logFormat == LOG_FORMAT_HTML) && m_logIsEmpty)
+	//Lines that have been collected so far are formatted with the old settings
+	submitBatch();
+
+	if(!formatter.isRawCapable())
 	{
-		m_logFile->operator<<("</table></body></html>\r\n");
+		disablePassthrough();
 	}
 
-	m_logFinished = true;
+	*m_formatter = formatter;
+	logString(QString("Config file has been reloaded: %1").arg(QDir::toNativeSeparators(m_config->fileName())), CHANNEL_SYSMSG);
 }
 
 // ===================================================
-// Setter methods
+// Private Methods
 // ===================================================
 
 /*
- * Set which streams to capture
- */
-void CLogProcessor::setCaptureStreams(const bool captureStdout, const bool captureStderr)
-{
-	m_logStdout = captureStdout;
-	m_logStderr = captureStderr;
-}
-
-/*
- * Set whether strings are simplified/trimmed
+ * Per-channel state of an input channel, the channel must be one of the input channels
  */
-void CLogProcessor::setSimplifyStrings(const bool simplify)
+CLogProcessor::channel_state_t &CLogProcessor::channelState(const int channel)
 {
-	m_simplify = simplify;
+	const int index = CHANNEL_INDEX[channel & 0x1F];
+	if((index < 0) || (channel & ~0x1F))
+	{
+		throw "Bad selection!";
+	}
+	return m_channels[index];
 }
 
 /*
- * Set verbose logging mode
+ * FLush any pending data from buffer
  */
-void CLogProcessor::setOutputFormat(const Format format)
+void CLogProcessor::flushBuffers(void)
 {
-	m_logFormat = format;
-}
+	for(int i = 0; i < CHANNEL_COUNT; i++)
+	{
+		const int channel = INPUT_CHANNELS[i];
+		if(((channel == CHANNEL_STDOUT) && (!m_logStdout)) || ((channel == CHANNEL_STDERR) && (!m_logStderr)))
+		{
+			continue;
+		}
+		if(!m_channels[i].head.isEmpty())
+		{
+			processData(QByteArray(), channel, true);
+		}
+		if(!m_channels[i].buffer.isEmpty())
+		{
+			logString(m_channels[i].buffer, channel);
+			m_channels[i].buffer.resize(0);
+		}
+	}
 
-/*
- * Set regular expressions for filtering
- */
-void CLogProcessor::setFilterStrings(const QString &regExpKeep, const QString &regExpSkip)
-{
-	if(!regExpKeep.isEmpty())
+	//Terminate incomplete lines of the passthrough mode
+	static const char lineBreak = '\n';
+	for(int i = 0; i < CHANNEL_COUNT; i++)
 	{
-		SAFE_DEL(m_regExpKeep);
-		m_regExpKeep = new QRegExp(regExpKeep);
+		if(!m_channels[i].raw.isEmpty()) processRaw(&lineBreak, 1, INPUT_CHANNELS[i]);
 	}
 
-	if(!regExpSkip.isEmpty())
+	//Binary data at the very end of a stream
+	if(m_binaryFilter)
 	{
-		SAFE_DEL(m_regExpSkip);
-		m_regExpSkip = new QRegExp(regExpSkip);
+		for(int i = 0; i < CHANNEL_COUNT; i++)
+		{
+			if(m_binaryFilter->isActive(INPUT_CHANNELS[i]))
+			{
+				logString(m_binaryFilter->takeSummary(INPUT_CHANNELS[i]), INPUT_CHANNELS[i]);
+			}
+		}
+		submitBatch();
 	}
+
+	waitBatches();
 }
 
 /*
- * Set text encodings
+ * Process data (decode and tokenize)
  */
-bool CLogProcessor::setTextCodecs(const char *inputCodec, const char *outputCodec)
+void CLogProcessor::processData(const QByteArray &data, const int channel, const bool endOfStream)
 {
-	if(inputCodec)
+	TRACE_STAGE(m_tracer, "split", data.length());
+
+	channel_state_t &state = channelState(channel);
+	QString *const buffer = &state.buffer;
+
+	//Decoders are created on demand, so there is none for channels that never deliver data
+	//The first bytes are held back until the head of the stream is complete, it decides about the codec and the BOM
+	QByteArray input(data);
+	int skip = 0;
+	if(!state.decoder)
 	{
-		QTextCodec *codec = QTextCodec::codecForName(inputCodec);
-		if(codec)
+		state.head.append(data);
+		int headLen = lengthOfHead(state.head.constData(), state.head.length());
+		if(headLen < 0)
+		{
+			if(!endOfStream)
+			{
+				return;
+			}
+			headLen = state.head.length();
+		}
+		input = state.head;
+		state.head.clear();
+
+		QTextCodec *codec = state.codec;
+		if(!codec)
 		{
-			SAFE_DEL(m_codecStdout); m_codecStdout = new QTextDecoder(codec);
-			SAFE_DEL(m_codecStderr); m_codecStderr = new QTextDecoder(codec);
+			codec = detectCodec(input.constData(), headLen, m_codecInput);
 		}
-		else
+		state.decoder = new QTextDecoder(codec);
+		if(isPassthrough(codec))
 		{
-			return false;
+			m_passthrough |= channel;
+			skip = lengthOfBom(input.constData(), input.length());
+		}
+		if(m_binaryFilter && isAsciiCompatible(codec))
+		{
+			m_binaryCheck |= channel;
+		}
+	}
+
+	const char *const bytes = input.constData() + skip;
+	const int len = input.length() - skip;
+
+	//Binary data is detected per block, within a binary block only the lines with control characters are binary
+	if(m_binaryCheck & channel)
+	{
+		const int blockSize = CBinaryFilter::BLOCK_SIZE;
+		int start = 0;
+		bool binary = false;
+		for(int pos = 0; pos < len; pos += blockSize)
+		{
+			const int blockLen = qMin(blockSize, len - pos);
+			int first = blockLen, last = blockLen;
+			if(CBinaryFilter::isBinary(bytes + pos, blockLen))
+			{
+				CBinaryFilter::binaryRange(bytes + pos, blockLen, first, last);
+			}
+
+			//The block consists of text [0, first), binary [first, last) and text [last, blockLen)
+			const int bounds[4] = { 0, first, last, blockLen };
+			for(int i = 0; i < 3; i++)
+			{
+				if(bounds[i + 1] <= bounds[i])
+				{
+					continue;
+				}
+				const bool segmentBinary = (i == 1);
+				const int segmentStart = pos + bounds[i];
+				if((segmentStart > start) && (segmentBinary != binary))
+				{
+					if(binary) processBinary(bytes + start, segmentStart - start, channel, buffer);
+					else processText(bytes + start, segmentStart - start, channel, buffer, state.decoder);
+					start = segmentStart;
+				}
+				binary = segmentBinary;
+			}
+		}
+		if(binary) processBinary(bytes + start, len - start, channel, buffer);
+		else processText(bytes + start, len - start, channel, buffer, state.decoder);
+	}
+	else
+	{
+		processText(bytes, len, channel, buffer, state.decoder);
+	}
+
+	//Report dropped lines and progress values from time to time
+	if(m_rateLimiter || m_extractor)
+	{
+		const qint64 now = CLogFormatter::currentTime();
+		if(m_rateLimiter && m_rateLimiter->isSummaryDue(now))
+		{
+			logString(m_rateLimiter->takeSummary(now), CHANNEL_SYSMSG);
+		}
+		if(m_extractor && m_extractor->isSummaryDue(now))
+		{
+			logString(m_extractor->takeSummary(now), CHANNEL_SYSMSG);
+		}
+	}
+
+	submitBatch();
+}
+
+/*
+ * Process text data (decode and tokenize, or pass through), the binary region of the channel ends here
+ */
+void CLogProcessor::processText(const char *data, const int len, const int channel, QString *buffer, QTextDecoder *decoder)
+{
+	if(m_binaryFilter && m_binaryFilter->isActive(channel))
+	{
+		logString(m_binaryFilter->takeSummary(channel), channel);
+		submitBatch();
+	}
+
+	//Bytes are written as-is, if they would be decoded and re-encoded with the same codec
+	if(m_passthrough & channel)
+	{
+		processRaw(data, len, channel);
+		return;
+	}
+
+	//Decode into re-usable buffer
+	m_bufferDecode.resize(0);
+	decoder->toUnicode(&m_bufferDecode, data, len);
+
+	const QChar *text = m_bufferDecode.constData();
+	const int textLen = m_bufferDecode.length();
+
+	int start = 0, pos = CLogFormatter::indexOfLineBreak(text, textLen);
+	while(pos >= 0)
+	{
+		if(!buffer->isEmpty())
+		{
+			//Complete the line that was carried over from the previous data
+			buffer->insert(buffer->length(), text + start, pos - start);
+			pushLine(buffer->constData(), buffer->length(), channel);
+			buffer->resize(0);
+		}
+		else if(pos > start)
+		{
+			pushLine(text + start, pos - start, channel);
+		}
+		start = pos + 1;
+		pos = CLogFormatter::indexOfLineBreak(text, textLen, start);
+	}
+
+	//Keep the incomplete line for later
+	if(start < textLen)
+	{
+		buffer->insert(buffer->length(), text + start, textLen - start);
+	}
+
+	//Huge lines are not kept in memory until they are complete
+	if((m_maxLineLength > 0) && (buffer->length() >= m_maxLineLength))
+	{
+		pushLine(buffer->constData(), buffer->length(), channel);
+		buffer->resize(0);
+	}
+}
+
+/*
+ * Process binary data, it is condensed into a summary line once the binary region ends
+ */
+void CLogProcessor::processBinary(const char *data, const int len, const int channel, QString *buffer)
+{
+	//The incomplete text line ends where the binary region begins
+	if(!m_binaryFilter->isActive(channel))
+	{
+		if(m_passthrough & channel)
+		{
+			static const char lineBreak = '\n';
+			processRaw(&lineBreak, 1, channel);
+		}
+		else if(!buffer->isEmpty())
+		{
+			pushLine(buffer->constData(), buffer->length(), channel);
+			buffer->resize(0);
+		}
+	}
+
+	m_binaryFilter->append(data, len, channel);
+}
+
+/*
+ * Process data in passthrough mode (tokenize and write without decoding)
+ */
+void CLogProcessor::processRaw(const char *data, const int len, const int channel)
+{
+	QByteArray *const buffer = &channelState(channel).raw;
+
+	//No logging if not ready
+	if((!m_logInitialized) || m_logFinished)
+	{
+		return;
+	}
+
+	//Only complete lines are written, the incomplete line is kept for later
+	int end = len;
+	while((end > 0) && (!CLogFormatter::isLineBreak(data[end - 1]))) end--;
+
+	if(end < 1)
+	{
+		buffer->append(data, len);
+		return;
+	}
+
+	//Make sure the lines will be written in order with the system messages
+	waitBatches();
+
+	const qint64 timeStamp = CLogFormatter::currentTime();
+	CLineBatch *batch = takeBatch();
+	int start = 0;
+
+	if(!buffer->isEmpty())
+	{
+		//Complete the line that was carried over from the previous data
+		while(!CLogFormatter::isLineBreak(data[start])) start++;
+		buffer->append(data, start);
+		batch->formatRaw(*m_formatter, buffer->constData(), buffer->length(), channel, timeStamp);
+		buffer->resize(0);
+	}
+
+	batch->formatRaw(*m_formatter, data + start, end - start, channel, timeStamp);
+	writeBatch(m_logFile, batch, m_tracer);
+	recycleBatch(batch);
+
+	if(end < len)
+	{
+		buffer->append(data + end, len - end);
+	}
+}
+
+/*
+ * Switch back to decoding, incomplete lines are handed over to the decoders
+ */
+void CLogProcessor::disablePassthrough(void)
+{
+	for(int i = 0; i < CHANNEL_COUNT; i++)
+	{
+		channel_state_t &state = m_channels[i];
+		if((!state.raw.isEmpty()) && state.decoder)
+		{
+			state.buffer.append(state.decoder->toUnicode(state.raw));
+			state.raw.resize(0);
+		}
+	}
+
+	m_passthrough = 0;
+}
+
+/*
+ * Bytes can be passed through, if the input codec matches the output codec and no line needs to be decoded
+ */
+bool CLogProcessor::isPassthrough(QTextCodec *codec) const
+{
+	return (codec == m_logFile->codec()) && isAsciiCompatible(codec) && m_formatter->isRawCapable() && (!m_rateLimiter) && (!m_extractor) && m_sinks.isEmpty() && (m_maxLineLength < 1);
+}
+
+/*
+ * Append string to log file
+ */
+void CLogProcessor::logString(const QString &data, const int channel)
+{
+	pushLine(data.constData(), data.length(), channel);
+
+	//Make sure the line will be written in order
+	if(channel == CHANNEL_SYSMSG)
+	{
+		submitBatch();
+	}
+}
+
+/*
+ * Append line to the current batch (data is copied)
+ */
+void CLogProcessor::pushLine(const QChar *data, const int len, const int channel)
+{
+	//No logging if not ready
+	if((!m_logInitialized) || m_logFinished || (len < 1))
+	{
+		return;
+	}
+
+	//Overlong lines are split into several records
+	if((m_maxLineLength > 0) && (len > m_maxLineLength) && (channel != CHANNEL_SYSMSG))
+	{
+		for(int pos = 0; pos < len; pos += m_maxLineLength)
+		{
+			pushLine(data + pos, qMin(m_maxLineLength, len - pos), channel);
+		}
+		return;
+	}
+
+	const qint64 timeStamp = CLogFormatter::currentTime();
+
+	//Progress lines are condensed into summaries
+	if(m_extractor && (channel != CHANNEL_SYSMSG) && m_extractor->process(data, len, timeStamp))
+	{
+		return;
+	}
+
+	//Drop lines early during floods, before they are copied
+	if(m_rateLimiter && (!m_rateLimiter->accept(data, len, channel, timeStamp)))
+	{
+		return;
+	}
+
+	const bool simplify = m_formatter->isSimplifyEnabled() && (channel != CHANNEL_SYSMSG);
+	m_batch->append(data, len, channel, timeStamp, simplify);
+
+	if(m_batch->count() >= BATCH_SIZE)
+	{
+		submitBatch();
+	}
+}
+
+/*
+ * Format the current batch, or send it to the thread pool (if enabled)
+ */
+void CLogProcessor::submitBatch(void)
+{
+	if(m_batch->isEmpty())
+	{
+		return;
+	}
+
+	if(m_threadCount < 1)
+	{
+		{
+			TRACE_STAGE(m_tracer, "format", m_batch->count());
+			m_batch->format(*m_formatter);
+		}
+		writeBatch(m_logFile, m_batch, m_tracer);
+		routeBatch(m_batch);
+		m_batch->reset();
+		return;
+	}
+
+	//Limit the number of batches in flight
+	while(m_pendingBatches.count() >= (4 * m_threadCount))
+	{
+		m_pendingBatches.first()->waitForFinished();
+		writeBatches();
+	}
+
+	QFutureWatcher<CLineBatch*> *watcher = new QFutureWatcher<CLineBatch*>();
+	connect(watcher, SIGNAL(finished()), this, SLOT(writeBatches()));
+	watcher->setFuture(QtConcurrent::run(processBatch, *m_formatter, m_batch));
+
+	m_pendingBatches.append(watcher);
+	m_batch = takeBatch();
+}
+
+/*
+ * Classify the lines of a batch and pass them to the sinks that accept their severity
+ */
+void CLogProcessor::routeBatch(const CLineBatch *batch)
+{
+	if(m_sinks.isEmpty())
+	{
+		return;
+	}
+
+	const QChar *const arena = batch->arena();
+	const line_t *const lines = batch->lines();
+
+	for(int i = 0; i < batch->count(); i++)
+	{
+		const quint32 severityBit = 1U << m_classifier->classify(arena + lines[i].offset, lines[i].length);
+		for(int j = 0; j < m_sinks.count(); j++)
+		{
+			if(m_sinks.at(j)->severityMask() & severityBit)
+			{
+				m_sinks.at(j)->append(lines[i]);
+			}
+		}
+	}
+
+	for(int j = 0; j < m_sinks.count(); j++)
+	{
+		m_sinks.at(j)->write(arena);
+	}
+
+	//Sinks are flushed whenever the main log has been flushed, so they do not lag behind it
+	bool failed = false;
+	const bool flushed = (m_logFile->flushedOffset() != m_sinkFlushOffset);
+	m_sinkFlushOffset = m_logFile->flushedOffset();
+	for(int j = 0; j < m_sinks.count(); j++)
+	{
+		if(flushed) m_sinks.at(j)->flush();
+		failed = failed || m_sinks.at(j)->hasError();
+	}
+
+	//Errors are logged later, the current batch is still in use
+	if(failed)
+	{
+		QMetaObject::invokeMethod(this, "reportSinkErrors", Qt::QueuedConnection);
+	}
+}
+
+/*
+ * Wait until all pending lines have been written
+ */
+void CLogProcessor::waitBatches(void)
+{
+	submitBatch();
+
+	while(!m_pendingBatches.isEmpty())
+	{
+		m_pendingBatches.first()->waitForFinished();
+		writeBatches();
+	}
+}
+
+/*
+ * Get an empty batch (re-used, if possible)
+ */
+CLineBatch *CLogProcessor::takeBatch(void)
+{
+	if(!m_freeBatches.isEmpty())
+	{
+		return m_freeBatches.takeLast();
+	}
+	return new CLineBatch();
+}
+
+/*
+ * Return a batch that has been written, so it can be re-used
+ */
+void CLogProcessor::recycleBatch(CLineBatch *batch)
+{
+	batch->reset();
+	m_freeBatches.append(batch);
+}
+
+/*
+ * Process input file in parallel (line-aligned chunks, written in original order)
+ */
+int CLogProcessor::processFile(void)
+{
+	//Chunks are written directly, so make sure nothing is pending
+	waitBatches();
+
+	QList<QFuture<CLineBatch*> > pending;
+	const int maxPending = qMax(2, 2 * QThreadPool::globalInstance()->maxThreadCount());
+
+	//Select the codec once, unless it was selected explicitly the first bytes of the file decide
+	const QByteArray head = m_inputFile->peek(DETECT_SIZE);
+	QTextCodec *codec = channelState(CHANNEL_STDINP).codec;
+	if(!codec)
+	{
+		const int headLen = lengthOfHead(head.constData(), head.length());
+		codec = detectCodec(head.constData(), (headLen < 0) ? head.length() : headLen, m_codecInput);
+	}
+
+	//Splitting at line break bytes is only safe for ASCII-compatible encodings
+	const bool splittable = isAsciiCompatible(codec);
+	const bool passthrough = isPassthrough(codec);
+	const qint64 bomSize = passthrough ? lengthOfBom(head.constData(), head.length()) : 0;
+
+	const qint64 fileSize = m_inputFile->size();
+	qint64 windowOffset = 0;
+	bool success = true;
+
+	//Files that can not be split are decoded sequentially, the decoder and the incomplete line carry over to the next chunk
+	QTextDecoder *decoder = splittable ? NULL : new QTextDecoder(codec);
+	QString buffer;
+
+	while(windowOffset < fileSize)
+	{
+		//Map the next window of the file
+		const qint64 windowSize = qMin(FILE_WINDOW_SIZE, fileSize - windowOffset);
+		const bool lastWindow = ((windowOffset + windowSize) >= fileSize);
+		uchar *window = m_inputFile->map(windowOffset, windowSize);
+
+		if(!window)
+		{
+			logString(QString("Failed to map the input file: %1").arg(m_inputFile->errorString()), CHANNEL_SYSMSG);
+			success = false;
+			break;
+		}
+
+		const char *data = reinterpret_cast<const char*>(window);
+		qint64 pos = (windowOffset == 0) ? bomSize : 0;
+
+		while(decoder && (pos < windowSize))
+		{
+			const int len = int(qMin(FILE_CHUNK_SIZE, windowSize - pos));
+			processText(data + pos, len, CHANNEL_STDINP, &buffer, decoder);
+			pos += len;
+		}
+
+		while(pos < windowSize)
+		{
+			qint64 end = windowSize;
+
+			if(splittable)
+			{
+				//Extend the chunk up to the next line break
+				qint64 eol = -1;
+				for(qint64 i = pos + FILE_CHUNK_SIZE - 1; i < windowSize; i++)
+				{
+					if(CLogFormatter::isLineBreak(data[i])) { eol = i; break; }
+				}
+
+				//Incomplete line at the end of the window is deferred to the next window
+				if((eol < 0) && (!lastWindow))
+				{
+					for(qint64 i = windowSize - 1; i >= pos; i--)
+					{
+						if(CLogFormatter::isLineBreak(data[i])) { eol = i; break; }
+					}
+					if((eol < 0) && (pos > 0))
+					{
+						break;
+					}
+				}
+
+				if(eol >= 0)
+				{
+					end = eol + 1;
+				}
+			}
+
+			while(pending.count() >= maxPending)
+			{
+				CLineBatch *batch = pending.takeFirst().result();
+				writeBatch(m_logFile, batch, m_tracer);
+				routeBatch(batch);
+				recycleBatch(batch);
+			}
+
+			if(passthrough)
+			{
+				pending.append(QtConcurrent::run(processChunkRaw, *m_formatter, data + pos, int(end - pos), takeBatch()));
+			}
+			else
+			{
+				pending.append(QtConcurrent::run(processChunk, *m_formatter, codec, data + pos, int(end - pos), takeBatch()));
+			}
+			pos = end;
+		}
+
+		//All chunks must be completed, before the window can be unmapped
+		while(!pending.isEmpty())
+		{
+			CLineBatch *batch = pending.takeFirst().result();
+			writeBatch(m_logFile, batch, m_tracer);
+			routeBatch(batch);
+			recycleBatch(batch);
+		}
+
+		m_inputFile->unmap(window);
+		windowOffset += pos;
+	}
+
+	if(decoder)
+	{
+		logString(buffer, CHANNEL_STDINP);
+		submitBatch();
+		waitBatches();
+		SAFE_DEL(decoder);
+	}
+
+	logString("No more data available from file (end of file reached)", CHANNEL_SYSMSG);
+	finishLog();
+
+	return success ? 0 : -1;
+}
+
+/*
+ * Initialize log file
+ */
+void CLogProcessor::initializeLog(void)
+{
+	if(m_logInitialized)
+	{
+		return;
+	}
+
+	if((m_formatter->format() == CLogFormatter::LOG_FORMAT_HTML) && m_logIsEmpty)
+	{
+		m_logFile->write("<!DOCTYPE html>\r\n");
+		m_logFile->write("<html><head><title>Log File</title></head><body><table style=\"font-family:monospace\" border>\r\n");
+		m_logFile->write("<tr><td>&nbsp;</td><td><b>Date</b></td><td><b>Time</b></td><td><b>Log Message</b></td></tr>\r\n");
+		m_logFile->setFooter(HTML_FOOTER);
+	}
+	if((m_formatter->format() == CLogFormatter::LOG_FORMAT_VERBOSE) && (!m_logIsEmpty))
+	{
+		m_logFile->write("---------------------------\r\n");
+	}
+
+	m_logInitialized = true;
+}
+
+/*
+ * Finish log file
+ */
+void CLogProcessor::finishLog(void)
+{
+	if((!m_logInitialized) || m_logFinished)
+	{
+		return;
+	}
+
+	waitBatches();
+	m_syncTimer->stop();
+
+	if(m_extractor && m_extractor->hasValues())
+	{
+		logString(m_extractor->takeSummary(CLogFormatter::currentTime()), CHANNEL_SYSMSG);
+		waitBatches();
+	}
+
+	if(m_rateLimiter && m_rateLimiter->hasDroppedLines())
+	{
+		logString(m_rateLimiter->takeSummary(CLogFormatter::currentTime()), CHANNEL_SYSMSG);
+		waitBatches();
+	}
+
+	if(m_logFile->durability() != CLogWriter::DURABILITY_NONE)
+	{
+		logString(m_logFile->statistics(), CHANNEL_SYSMSG);
+		waitBatches();
+	}
+
+	for(int i = 0; i < m_sinks.count(); i++)
+	{
+		m_sinks.at(i)->flush();
+	}
+	reportSinkErrors();
+	waitBatches();
+
+	if(const quint64 failedBytes = m_logFile->failedBytes())
+	{
+		logString(QString("Writing to the log file has failed, %1 bytes of data have been lost!").arg(failedBytes), CHANNEL_SYSMSG);
+		waitBatches();
+	}
+
+	if((m_formatter->format() == CLogFormatter::LOG_FORMAT_HTML) && m_logIsEmpty)
+	{
+		m_logFile->setFooter(QString());
+		m_logFile->write(HTML_FOOTER);
+	}
+
+	m_logFile->commit(true);
+	m_logFinished = true;
+}
+
+// ===================================================
+// Setter methods
+// ===================================================
+
+/*
+ * Set which streams to capture
+ */
+void CLogProcessor::setCaptureStreams(const bool captureStdout, const bool captureStderr)
+{
+	m_logStdout = captureStdout;
+	m_logStderr = captureStderr;
+}
+
+/*
+ * Set whether strings are simplified/trimmed
+ */
+void CLogProcessor::setSimplifyStrings(const bool simplify)
+{
+	m_formatter->setSimplify(simplify);
+}
+
+/*
+ * Set verbose logging mode
+ */
+void CLogProcessor::setOutputFormat(const CLogFormatter::Format format)
+{
+	m_formatter->setFormat(format);
+}
+
+/*
+ * Set granularity of the sidecar index (zero disables)
+ */
+bool CLogProcessor::setIndexGranularity(const qint64 everyBytes, const qint64 everyMSecs)
+{
+	return m_logFile->setIndex(everyBytes, everyMSecs);
+}
+
+/*
+ * Set number of worker threads for filtering and formatting (zero disables)
+ */
+void CLogProcessor::setThreadCount(const int threadCount)
+{
+	m_threadCount = qMax(threadCount, 0);
+	if(m_threadCount > 0)
+	{
+		QThreadPool::globalInstance()->setMaxThreadCount(m_threadCount);
+	}
+}
+
+/*
+ * Set whether time stamps include microseconds
+ */
+void CLogProcessor::setPreciseTime(const bool preciseTime)
+{
+	m_formatter->setPreciseTime(preciseTime);
+}
+
+/*
+ * Set durability level of the log file
+ */
+void CLogProcessor::setDurability(const CLogWriter::Durability durability, const qint64 intervalMSecs)
+{
+	m_logFile->setDurability(durability, intervalMSecs);
+
+	//The writer enforces a minimum interval, because each sync blocks the event loop
+	if(durability == CLogWriter::DURABILITY_INTERVAL)
+	{
+		m_syncTimer->start(int(qMin(m_logFile->syncInterval(), Q_INT64_C(0x7FFFFFFF))));
+	}
+	else
+	{
+		m_syncTimer->stop();
+	}
+}
+
+/*
+ * Log resource usage of the process every N milliseconds (zero logs only the totals, negative disables)
+ */
+void CLogProcessor::setProcessStatistics(const qint64 intervalMSecs)
+{
+	m_statsInterval = intervalMSecs;
+}
+
+/*
+ * Enable the crash-safe journal for data that has not been written yet
+ */
+bool CLogProcessor::setJournal(const bool enable)
+{
+	return m_logFile->setJournal(enable);
+}
+
+/*
+ * Set limits for STDIN (or followed file) data buffered in memory and on disk (zero means unlimited)
+ */
+void CLogProcessor::setBufferLimits(const qint64 maxRam, const qint64 maxSpill)
+{
+	m_maxRam = maxRam;
+	m_maxSpill = maxSpill;
+
+	if(m_stdinReader)
+	{
+		m_stdinReader->setBufferLimits(maxRam, maxSpill);
+	}
+
+	if(m_follower)
+	{
+		m_follower->setBufferLimits(maxRam, maxSpill);
+	}
+}
+
+/*
+ * Limit the number of lines per second and channel (zero disables), lines matching the priority pattern are always kept
+ */
+void CLogProcessor::setRateLimit(const quint32 linesPerSecond, const quint32 sampleEvery, const QString &regExpPriority)
+{
+	SAFE_DEL(m_rateLimiter);
+
+	if(linesPerSecond > 0)
+	{
+		m_rateLimiter = new CRateLimiter(linesPerSecond, sampleEvery);
+		m_rateLimiter->setPriority(regExpPriority);
+	}
+}
+
+/*
+ * Watch the config file, the filter and format options are re-applied whenever it changes
+ */
+bool CLogProcessor::setConfigFile(const QString &fileName, const QStringList &overrides)
+{
+	SAFE_DEL(m_config);
+
+	if(fileName.isEmpty())
+	{
+		return true;
+	}
+
+	m_config = new CConfigFile(fileName);
+	if(!(m_config->load() && m_config->watch()))
+	{
+		SAFE_DEL(m_config);
+		return false;
+	}
+
+	m_config->setOverrides(overrides);
+
+	connect(m_config, SIGNAL(changed()), this, SLOT(reloadConfig()));
+	return true;
+}
+
+/*
+ * Condense lines matching the given regular expressions into periodic summaries of the captured values
+ */
+bool CLogProcessor::setExtractFields(const QStringList &names, const QStringList &regExps, const qint64 intervalMSecs)
+{
+	SAFE_DEL(m_extractor);
+
+	if(names.isEmpty())
+	{
+		return true;
+	}
+
+	m_extractor = new CValueExtractor(intervalMSecs);
+	for(int i = 0; i < qMin(names.count(), regExps.count()); i++)
+	{
+		if(!m_extractor->addField(names.at(i), regExps.at(i)))
+		{
+			SAFE_DEL(m_extractor);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Replace the keywords that classify lines as the given severity
+ */
+bool CLogProcessor::setSeverityKeywords(const int severity, const QStringList &keywords)
+{
+	if(!m_classifier)
+	{
+		m_classifier = new CSeverityClassifier();
+	}
+
+	return m_classifier->setKeywords(CSeverityClassifier::Severity(severity), keywords);
+}
+
+/*
+ * Add a secondary output for lines of the selected severities (mask bit N selects severity N)
+ */
+bool CLogProcessor::addSink(const QString &fileName, const quint32 severityMask, const CLogFormatter::Format format, const qint64 rotateSize, const bool compress, const bool append)
+{
+	//Sinks share the filter settings of the main log, but use their own format
+	CLogFormatter formatter(*m_formatter);
+	formatter.setFormat(format);
+
+	CLogSink *sink = new CLogSink(fileName, formatter, severityMask);
+	sink->setCodec(m_logFile->codec());
+	sink->setRotation(rotateSize, SINK_ROTATE_KEEP);
+	sink->setCompression(compress);
+
+	if(!sink->open(append))
+	{
+		delete sink;
+		return false;
+	}
+
+	if(!m_classifier)
+	{
+		m_classifier = new CSeverityClassifier();
+	}
+
+	m_sinks.append(sink);
+	return true;
+}
+
+/*
+ * Condense binary data into summary lines (the side file receives the binary data, if not empty)
+ */
+bool CLogProcessor::setBinaryHandling(const bool enable, const CBinaryFilter::Mode mode, const QString &sideFileName)
+{
+	SAFE_DEL(m_binaryFilter);
+	m_binaryCheck = 0;
+
+	if(enable)
+	{
+		m_binaryFilter = new CBinaryFilter(mode);
+		if(!m_binaryFilter->setSideFile(sideFileName))
+		{
+			SAFE_DEL(m_binaryFilter);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Split lines that are longer than the limit (zero means unlimited)
+ */
+void CLogProcessor::setMaxLineLength(const int maxLength)
+{
+	m_maxLineLength = qMax(maxLength, 0);
+}
+
+/*
+ * Run the child process on a pseudo console of the given size (zero columns means pipes)
+ */
+void CLogProcessor::setPseudoConsole(const int columns, const int rows)
+{
+	m_ptyColumns = qMax(columns, 0);
+	m_ptyRows = qMax(rows, 1);
+}
+
+/*
+ * Trace every N-th chunk of input to a Chrome trace file (empty file name disables tracing)
+ */
+bool CLogProcessor::setTrace(const QString &fileName, const quint32 sampleEvery)
+{
+	SAFE_DEL(m_tracer);
+
+	if(fileName.isEmpty())
+	{
+		return true;
+	}
+
+	m_tracer = new CLatencyTracer(sampleEvery);
+	if(!m_tracer->open(fileName))
+	{
+		SAFE_DEL(m_tracer);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Set whether captured data is echoed to the console (disabled for daemon sessions)
+ */
+void CLogProcessor::setEcho(const bool echo)
+{
+	m_echo = echo;
+}
+
+/*
+ * Set regular expressions for filtering
+ */
+void CLogProcessor::setFilterStrings(const QString &regExpKeep, const QString &regExpSkip)
+{
+	m_formatter->setFilter(regExpKeep, regExpSkip);
+}
+
+/*
+ * Set text encodings
+ */
+bool CLogProcessor::setTextCodecs(const char *inputCodec, const char *outputCodec)
+{
+	if(inputCodec)
+	{
+		QTextCodec *codec = QTextCodec::codecForName(inputCodec);
+		if(codec)
+		{
+			//Decoders will be re-created with the new codec on demand
+			m_codecInput = codec;
+			for(int i = 0; i < CHANNEL_COUNT; i++)
+			{
+				SAFE_DEL(m_channels[i].decoder);
+			}
+		}
+		else
+		{
+			return false;
 		}
 	}
 
@@ -579,6 +1752,10 @@ bool CLogProcessor::setTextCodecs(const char *inputCodec, const char *outputCode
 		if(codec)
 		{
 			m_logFile->setCodec(codec);
+			for(int i = 0; i < m_sinks.count(); i++)
+			{
+				m_sinks.at(i)->setCodec(codec);
+			}
 		}
 		else
 		{
@@ -589,22 +1766,165 @@ bool CLogProcessor::setTextCodecs(const char *inputCodec, const char *outputCode
 	return true;
 }
 
+/*
+ * Set the text encoding of a single input channel (disables auto-detection for that channel)
+ */
+bool CLogProcessor::setChannelCodec(const int channel, const char *inputCodec)
+{
+	QTextCodec *codec = QTextCodec::codecForName(inputCodec);
+	if(!codec)
+	{
+		return false;
+	}
+
+	//Codecs can be selected for the streams only, a followed file is always auto-detected
+	if((channel != CHANNEL_STDOUT) && (channel != CHANNEL_STDERR) && (channel != CHANNEL_STDINP))
+	{
+		return false;
+	}
+
+	//The decoder will be re-created with the new codec on demand
+	channel_state_t &state = channelState(channel);
+	state.codec = codec;
+	SAFE_DEL(state.decoder);
+	return true;
+}
+
 // ===================================================
 // Misc Stuff
 // ===================================================
 
 /*
- * Escape (some) HTML characters
+ * Decode, tokenize and format one chunk of an input file (runs on the thread pool)
  */
-QString CLogProcessor::escape(const QString &text)
+static CLineBatch *processChunk(const CLogFormatter &formatter, QTextCodec *codec, const char *data, const int len, CLineBatch *batch)
 {
-	QString escaped(text);
-	
-	escaped.replace('<', "&lt;");
-	escaped.replace('>', "&gt;");
-	escaped.replace('&', "&amp;");
-	escaped.replace('"', "&quot;");
-	escaped.replace(' ', "&nbsp;");
+	const qint64 timeStamp = CLogFormatter::currentTime();
+	const QString text = codec->toUnicode(data, len);
 
-	return escaped;
+	int start = 0;
+	while(start < text.length())
+	{
+		const int pos = CLogFormatter::indexOfLineBreak(text.constData(), text.length(), start);
+		const int end = (pos >= 0) ? pos : text.length();
+		if(end > start)
+		{
+			batch->append(text.constData() + start, end - start, CHANNEL_STDINP, timeStamp, formatter.isSimplifyEnabled());
+		}
+		start = end + 1;
+	}
+
+	batch->format(formatter);
+	return batch;
+}
+
+/*
+ * Tokenize and format one chunk of an input file in passthrough mode (runs on the thread pool)
+ */
+static CLineBatch *processChunkRaw(const CLogFormatter &formatter, const char *data, const int len, CLineBatch *batch)
+{
+	batch->formatRaw(formatter, data, len, CHANNEL_STDINP, CLogFormatter::currentTime());
+	return batch;
+}
+
+/*
+ * Detect the encoding from the first bytes of a stream (BOM or NUL bytes of UTF-16 text)
+ */
+static QTextCodec *detectCodec(const char *data, const int len, QTextCodec *fallback)
+{
+	const uchar *bytes = reinterpret_cast<const uchar*>(data);
+
+	//Byte order marks, the decoder skips them
+	if((len >= 3) && (bytes[0] == 0xEF) && (bytes[1] == 0xBB) && (bytes[2] == 0xBF))
+	{
+		return QTextCodec::codecForName("UTF-8");
+	}
+	if((len >= 2) && (((bytes[0] == 0xFF) && (bytes[1] == 0xFE)) || ((bytes[0] == 0xFE) && (bytes[1] == 0xFF))))
+	{
+		return QTextCodec::codecForName("UTF-16");
+	}
+
+	//Text never contains NUL bytes, except for the high (or low) bytes of ASCII characters in UTF-16
+	int zeroEven = 0, zeroOdd = 0;
+	const int pairs = qMin(len, DETECT_SIZE) / 2;
+	for(int i = 0; i < pairs; i++)
+	{
+		if(!bytes[2 * i]) zeroEven++;
+		if(!bytes[2 * i + 1]) zeroOdd++;
+	}
+	if((pairs > 0) && (zeroEven == 0) && (2 * zeroOdd >= pairs))
+	{
+		return QTextCodec::codecForName("UTF-16LE");
+	}
+	if((pairs > 0) && (zeroOdd == 0) && (2 * zeroEven >= pairs))
+	{
+		return QTextCodec::codecForName("UTF-16BE");
+	}
+
+	return fallback;
+}
+
+/*
+ * Check whether line breaks are encoded as single bytes of the same value
+ */
+static bool isAsciiCompatible(QTextCodec *codec)
+{
+	static const char lineBreaks[] = "\n\r\f\v\b";
+	return (codec->fromUnicode(QString::fromLatin1(lineBreaks)) == QByteArray(lineBreaks));
+}
+
+/*
+ * Length of the UTF-8 BOM at the beginning of the data, if any
+ */
+static int lengthOfBom(const char *data, const int len)
+{
+	return ((len >= 3) && (data[0] == '\xEF') && (data[1] == '\xBB') && (data[2] == '\xBF')) ? 3 : 0;
+}
+
+/*
+ * Length of the head of a stream that is used to detect the codec, or -1 if more bytes are needed
+ * The head ends one byte after the first line break (the high byte of UTF-16 text), so it does not depend on how the stream is split
+ */
+static int lengthOfHead(const char *data, const int len)
+{
+	const int limit = qMin(len, DETECT_SIZE);
+	for(int i = 0; i < limit; i++)
+	{
+		if((data[i] == '\n') || (data[i] == '\r'))
+		{
+			return (i + 1 >= DETECT_SIZE) ? DETECT_SIZE : ((i + 1 < len) ? (i + 2) : -1);
+		}
+	}
+	return (len >= DETECT_SIZE) ? DETECT_SIZE : -1;
+}
+
+/*
+ * Filter and format a batch of lines (runs on the thread pool)
+ */
+static CLineBatch *processBatch(const CLogFormatter &formatter, CLineBatch *batch)
+{
+	batch->format(formatter);
+	return batch;
+}
+
+/*
+ * Write the result of one batch to the log file
+ */
+static void writeBatch(CLogWriter *logFile, const CLineBatch *batch, CLatencyTracer *tracer)
+{
+	TRACE_STAGE(tracer, "write", batch->records());
+
+	if(batch->records() > 0)
+	{
+		logFile->beginRecord(batch->timeStamp() / 1000, batch->records());
+		if(batch->rawLength() > 0)
+		{
+			logFile->write(batch->rawOutput(), batch->rawLength());
+		}
+		if(!batch->output().isEmpty())
+		{
+			logFile->write(batch->output());
+		}
+		logFile->commit();
+	}
 }
@@ -22,94 +22,182 @@
 #pragma once
 
 #include <QObject>
+#include <QList>
+
+//Internal
+#include "LogFormatter.h"
+#include "LogWriter.h"
+#include "BinaryFilter.h"
 
 //Forward declaration
-class QProcess;
+class QTextCodec;
 class QTextDecoder;
 class QStringList;
-class QTextStream;
 class QFile;
 class QEventLoop;
+class QTimer;
 class CInputReader;
+class CFileFollower;
+class CChildProcess;
+class CLineBatch;
+class CRateLimiter;
+class CSeverityClassifier;
+class CLogSink;
+class CProcessMonitor;
+class CValueExtractor;
+class CConfigFile;
+class CLatencyTracer;
+template <typename T> class QFutureWatcher;
 
 //Class CLogProcessor
 class CLogProcessor : public QObject
 {
 	Q_OBJECT
+	friend class CTokenizerTest;
+	friend class CTokenizerFuzzer;
 
 public:
-	CLogProcessor(QFile &logFile);
+	CLogProcessor(QFile &logFile, void *inputHandle = NULL);
 	~CLogProcessor(void);
 
 	//Start logging
 	bool startProcess(const QString &program, const QStringList &arguments);
 	bool startStdinProcessing(void);
+	bool startFileProcessing(const QString &fileName);
+	bool startFileFollowing(const QString &fileName);
 	
 	//Event processing
 	int exec(void);
 
-	//Types
-	typedef enum
-	{
-		LOG_FORMAT_PLAIN = 0,
-		LOG_FORMAT_VERBOSE = 1,
-		LOG_FORMAT_HTML = 2
-	}
-	Format;
-
 	//Setter methods
 	void setCaptureStreams(const bool captureStdout, const bool captureStderr);
 	void setSimplifyStrings(const bool simplify);
 	void setFilterStrings(const QString &regExpKeep, const QString &regExpSkip);
 	bool setTextCodecs(const char *inputCodec, const char *outputCodec);
-	void setOutputFormat(const Format format);
+	bool setChannelCodec(const int channel, const char *inputCodec);
+	void setOutputFormat(const CLogFormatter::Format format);
+	void setPreciseTime(const bool preciseTime);
+	bool setIndexGranularity(const qint64 everyBytes, const qint64 everyMSecs);
+	void setThreadCount(const int threadCount);
+	void setDurability(const CLogWriter::Durability durability, const qint64 intervalMSecs);
+	bool setJournal(const bool enable);
+	void setBufferLimits(const qint64 maxRam, const qint64 maxSpill);
+	void setEcho(const bool echo);
+	void setProcessStatistics(const qint64 intervalMSecs);
+	void setRateLimit(const quint32 linesPerSecond, const quint32 sampleEvery, const QString &regExpPriority);
+	bool setExtractFields(const QStringList &names, const QStringList &regExps, const qint64 intervalMSecs);
+	bool setSeverityKeywords(const int severity, const QStringList &keywords);
+	bool setConfigFile(const QString &fileName, const QStringList &overrides);
+	bool setBinaryHandling(const bool enable, const CBinaryFilter::Mode mode, const QString &sideFileName);
+	void setMaxLineLength(const int maxLength);
+	void setPseudoConsole(const int columns, const int rows);
+	bool setTrace(const QString &fileName, const quint32 sampleEvery);
+	bool addSink(const QString &fileName, const quint32 severityMask, const CLogFormatter::Format format, const qint64 rotateSize, const bool compress, const bool append);
 
 public slots:
 	void forceQuit(const bool silent = false);
 
+signals:
+	void finished(int exitCode);
+
 
 private slots:
 	void readFromStdout(void);
 	void readFromStderr(void);
 	void readFromStdinp(void);
+	void readFromFile(void);
 
 	void processFinished(int exitCode);
 	void readerFinished(void);
+	void followerFinished(void);
+	void followerEvent(const QString &message);
+
+	void writeBatches(void);
+	void syncLog(void);
+	void sampleProcess(void);
+	void reloadConfig(void);
+	void reportSinkErrors(void);
 
 private:
+	//Types
+	static const int CHANNEL_COUNT = 4;
+	typedef struct
+	{
+		QString buffer;     //incomplete line (decoded)
+		QByteArray raw;     //incomplete line (passthrough mode)
+		QByteArray head;    //first bytes, held back until the codec has been detected
+		QTextDecoder *decoder;
+		QTextCodec *codec;  //selected by the user, NULL means auto-detect
+	}
+	channel_state_t;
+
+	channel_state_t &channelState(const int channel);
 	void flushBuffers(void);
-	void processData(const QByteArray &data, const int channel);
+	void processData(const QByteArray &data, const int channel, const bool endOfStream = false);
+	void processText(const char *data, const int len, const int channel, QString *buffer, QTextDecoder *decoder);
+	void processBinary(const char *data, const int len, const int channel, QString *buffer);
+	void processRaw(const char *data, const int len, const int channel);
+	bool isPassthrough(QTextCodec *codec) const;
+	void disablePassthrough(void);
 	void logString(const QString &data, const int channel);
+	void pushLine(const QChar *data, const int len, const int channel);
 	void initializeLog(void);
 	void finishLog(void);
-
-	static QString escape(const QString &text);
-
-	QProcess *m_process;
+	int processFile(void);
+	void submitBatch(void);
+	void routeBatch(const CLineBatch *batch);
+	void waitBatches(void);
+	void recycleBatch(CLineBatch *batch);
+	CLineBatch *takeBatch(void);
+
+	CChildProcess *m_process;
 	CInputReader *m_stdinReader;
+	CFileFollower *m_follower;
+	void *const m_inputHandle;
+	qint64 m_maxRam;
+	qint64 m_maxSpill;
+	QFile *m_inputFile;
 	
 	bool m_logStdout;
 	bool m_logStderr;
-	bool m_simplify;
+	bool m_echo;
 
 	const bool m_logIsEmpty;
 
-	Format m_logFormat;
+	CLogFormatter *m_formatter;
+	CRateLimiter *m_rateLimiter;
+	CSeverityClassifier *m_classifier;
+	CValueExtractor *m_extractor;
+	CConfigFile *m_config;
+	QList<CLogSink*> m_sinks;
+	qint64 m_sinkFlushOffset;
+
+	int m_threadCount;
+	CLineBatch *m_batch;
+	QList<CLineBatch*> m_freeBatches;
+	QList<QFutureWatcher<CLineBatch*>*> m_pendingBatches;
 	
-	QTextDecoder *m_codecStdout;
-	QTextDecoder *m_codecStderr;
-	QTextDecoder *m_codecStdinp;
+	QTextCodec *m_codecInput;
+	channel_state_t m_channels[CHANNEL_COUNT];
+	QString m_bufferDecode;
+	int m_passthrough;
+
+	int m_binaryCheck;
+	CBinaryFilter *m_binaryFilter;
+	int m_maxLineLength;
 
-	QString m_bufferStdout;
-	QString m_bufferStderr;
-	QString m_bufferStdinp;
+	int m_ptyColumns;
+	int m_ptyRows;
 
-	QRegExp *m_regExpEOL;
-	QRegExp *m_regExpSkip;
-	QRegExp *m_regExpKeep;
+	CLatencyTracer *m_tracer;
 
-	QTextStream *m_logFile;
+	CLogWriter *m_logFile;
 	QEventLoop *m_eventLoop;
+	QTimer *m_syncTimer;
+
+	CProcessMonitor *m_monitor;
+	QTimer *m_statsTimer;
+	qint64 m_statsInterval;
 
 	bool m_logInitialized;
 	bool m_logFinished;
@@ -0,0 +1,276 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "LogSink.h"
+
+//Qt
+#include <QTextCodec>
+#include <QDir>
+
+//Const
+static const int BUFFER_SIZE = 65536;
+static const int COMPRESS_BLOCK_SIZE = 262144;
+
+//Helper
+#define SAFE_DEL(X) do { if(X) { delete (X); X = NULL; } } while (0)
+
+//Forward declarations
+static quint32 crc32(const char *data, const int len);
+
+/*
+ * Constructor
+ */
+CLogSink::CLogSink(const QString &fileName, const CLogFormatter &formatter, const quint32 severityMask)
+:
+	m_severityMask(severityMask),
+	m_formatter(formatter),
+	m_file(fileName),
+	m_maxSize(0),
+	m_keepFiles(0),
+	m_compress(false),
+	m_failed(false)
+{
+	m_encoder = QTextCodec::codecForName("UTF-8")->makeEncoder(QTextCodec::IgnoreHeader);
+	m_output.reserve(BUFFER_SIZE);
+}
+
+/*
+ * Destructor
+ */
+CLogSink::~CLogSink(void)
+{
+	close();
+	SAFE_DEL(m_encoder);
+}
+
+/*
+ * Open the output file
+ */
+bool CLogSink::open(const bool append)
+{
+	return m_file.open(append ? QIODevice::Append : (QIODevice::WriteOnly | QIODevice::Truncate));
+}
+
+/*
+ * Write pending data and close the output file
+ */
+void CLogSink::close(void)
+{
+	if(m_file.isOpen())
+	{
+		flush();
+		m_file.close();
+	}
+}
+
+/*
+ * Format and write the lines that have been routed to this sink
+ */
+void CLogSink::write(const QChar *arena)
+{
+	if(m_lines.isEmpty())
+	{
+		return;
+	}
+
+	m_output.resize(0);
+	if(m_formatter.formatBatch(m_output, arena, m_lines.constData(), m_lines.count()) > 0)
+	{
+		m_pending.append(m_encoder->fromUnicode(m_output));
+	}
+	m_lines.resize(0);
+
+	if(m_pending.size() >= (m_compress ? COMPRESS_BLOCK_SIZE : BUFFER_SIZE))
+	{
+		flush();
+	}
+}
+
+/*
+ * Set the encoding of the output (default: UTF-8)
+ */
+void CLogSink::setCodec(QTextCodec *codec)
+{
+	SAFE_DEL(m_encoder);
+	m_encoder = codec->makeEncoder(QTextCodec::IgnoreHeader);
+}
+
+/*
+ * Rotate the file once it has reached this size, older files are kept as "<name>.1" to "<name>.N"
+ */
+void CLogSink::setRotation(const qint64 maxSize, const int keepFiles)
+{
+	m_maxSize = qMax(maxSize, Q_INT64_C(0));
+	m_keepFiles = qMax(keepFiles, 1);
+}
+
+/*
+ * Write the pending data (compressed data is written as one gzip member per block)
+ */
+void CLogSink::flush(void)
+{
+	if(m_pending.isEmpty())
+	{
+		return;
+	}
+
+	if(!m_file.isOpen())
+	{
+		setError(QString("Sink file is not open, data has been lost: %1").arg(QDir::toNativeSeparators(m_file.fileName())));
+		m_pending.resize(0);
+		return;
+	}
+
+	const QByteArray data = m_compress ? gzipMember(m_pending) : m_pending;
+	m_pending.resize(0);
+
+	if(!(m_file.write(data) == qint64(data.size()) && m_file.flush()))
+	{
+		setError(QString("Failed to write sink file: %1").arg(QDir::toNativeSeparators(m_file.fileName())));
+		return;
+	}
+
+	if((m_maxSize > 0) && (m_file.size() >= m_maxSize))
+	{
+		if(!rotate())
+		{
+			setError(QString("Failed to rotate sink file, writing to the current file: %1").arg(QDir::toNativeSeparators(m_file.fileName())));
+			return;
+		}
+	}
+
+	m_failed = false;
+}
+
+/*
+ * Shift the older files and start a new one, if that fails the current file stays open
+ */
+bool CLogSink::rotate(void)
+{
+	const QString fileName = m_file.fileName();
+	const QString firstName = QString("%1.1").arg(fileName);
+	m_file.close();
+
+	QFile::remove(QString("%1.%2").arg(fileName, QString::number(m_keepFiles)));
+	for(int i = m_keepFiles - 1; i > 0; i--)
+	{
+		QFile::rename(QString("%1.%2").arg(fileName, QString::number(i)), QString("%1.%2").arg(fileName, QString::number(i + 1)));
+	}
+
+	if(QFile::rename(fileName, firstName))
+	{
+		if(m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		{
+			return true;
+		}
+		QFile::rename(firstName, fileName);
+	}
+
+	//Keep writing to the current file
+	m_file.open(QIODevice::Append);
+	return false;
+}
+
+/*
+ * Remember the error, it is reported once until writing succeeds again
+ */
+void CLogSink::setError(const QString &error)
+{
+	if(!m_failed)
+	{
+		m_error = error;
+		m_failed = true;
+	}
+}
+
+/*
+ * Take the error message that has not been reported yet
+ */
+QString CLogSink::takeError(void)
+{
+	const QString error = m_error;
+	m_error.clear();
+	return error;
+}
+
+/*
+ * Create a gzip member from the zlib stream of qCompress (concatenated members form a valid gzip file)
+ */
+QByteArray CLogSink::gzipMember(const QByteArray &data)
+{
+	static const char header[10] = { '\x1F', '\x8B', '\x08', '\0', '\0', '\0', '\0', '\0', '\0', '\x0B' };
+
+	//Layout of qCompress output: 4 bytes length, 2 bytes zlib header, raw deflate data, 4 bytes Adler-32
+	const QByteArray zlibData = qCompress(data);
+	if(zlibData.size() < 10)
+	{
+		return QByteArray();
+	}
+
+	const quint32 trailer[2] = { crc32(data.constData(), data.size()), quint32(data.size()) };
+
+	QByteArray member;
+	member.reserve(zlibData.size() + 12);
+	member.append(header, sizeof(header));
+	member.append(zlibData.constData() + 6, zlibData.size() - 10);
+	member.append(reinterpret_cast<const char*>(trailer), sizeof(trailer));
+	return member;
+}
+
+// ===================================================
+// Misc Stuff
+// ===================================================
+
+/*
+ * CRC-32 lookup table, built before main() so that sinks on different threads can share it
+ */
+static const class CCrcTable
+{
+public:
+	CCrcTable(void)
+	{
+		for(quint32 i = 0; i < 256; i++)
+		{
+			quint32 c = i;
+			for(int k = 0; k < 8; k++)
+			{
+				c = (c & 1) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+			}
+			values[i] = c;
+		}
+	}
+	quint32 values[256];
+}
+g_crcTable;
+
+/*
+ * CRC-32 as used by gzip
+ */
+static quint32 crc32(const char *data, const int len)
+{
+	quint32 crc = 0xFFFFFFFFU;
+	for(int i = 0; i < len; i++)
+	{
+		crc = g_crcTable.values[(crc ^ quint8(data[i])) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFFU;
+}
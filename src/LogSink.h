@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QFile>
+#include <QVector>
+
+//Internal
+#include "LogFormatter.h"
+
+//Forward declaration
+class QTextCodec;
+class QTextEncoder;
+
+//Class CLogSink
+//Secondary log output for selected severities, with its own format, size based rotation and optional gzip compression
+class CLogSink
+{
+public:
+	CLogSink(const QString &fileName, const CLogFormatter &formatter, const quint32 severityMask);
+	~CLogSink(void);
+
+	bool open(const bool append);
+	void close(void);
+
+	//Line processing
+	void append(const line_t &line) { m_lines.append(line); }
+	void write(const QChar *arena);
+	void flush(void);
+
+	//Setter methods
+	void setCodec(QTextCodec *codec);
+	void setRotation(const qint64 maxSize, const int keepFiles);
+	void setCompression(const bool compress) { m_compress = compress; }
+
+	//Getter methods
+	quint32 severityMask(void) const { return m_severityMask; }
+	bool hasError(void) const { return !m_error.isEmpty(); }
+	QString takeError(void);
+
+private:
+	CLogSink(const CLogSink&);
+	CLogSink &operator=(const CLogSink&);
+
+	bool rotate(void);
+	void setError(const QString &error);
+	static QByteArray gzipMember(const QByteArray &data);
+
+	const quint32 m_severityMask;
+	CLogFormatter m_formatter;
+	QTextEncoder *m_encoder;
+	QFile m_file;
+
+	QVector<line_t> m_lines;
+	QString m_output;
+	QByteArray m_pending;
+
+	qint64 m_maxSize;
+	int m_keepFiles;
+	bool m_compress;
+
+	QString m_error;
+	bool m_failed;
+};
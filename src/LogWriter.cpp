@@ -0,0 +1,443 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LogWriter.h"
+
+//Windows
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+//Qt
+#include <QFile>
+#include <QTextCodec>
+#include <QDateTime>
+#include <QElapsedTimer>
+
+//CRT
+#include <io.h>
+
+//Internal
+#include "LogIndex.h"
+#include "LogJournal.h"
+
+//Const
+static const int BUFFER_SIZE = 65536;
+static const qint64 MIN_SYNC_INTERVAL = 100;
+
+//Helper
+#define SAFE_DEL(X) do { if(X) { delete (X); X = NULL; } } while (0)
+
+/*
+ * Constructor
+ */
+CLogWriter::CLogWriter(QFile &logFile, const bool generateBom)
+:
+	m_logFile(logFile),
+	m_generateBom(generateBom),
+	m_records(0),
+	m_index(NULL),
+	m_indexBytes(0),
+	m_indexMSecs(0),
+	m_lastIndexOffset(0),
+	m_lastIndexTime(0),
+	m_journal(NULL),
+	m_failedBytes(0),
+	m_durability(DURABILITY_NONE),
+	m_syncInterval(0),
+	m_lastSyncTime(0),
+	m_oldestPending(-1),
+	m_syncPending(false),
+	m_syncCount(0),
+	m_syncTotalUSecs(0),
+	m_syncMaxUSecs(0),
+	m_latencyTotalMSecs(0),
+	m_latencyMaxMSecs(0)
+{
+	m_fileOffset = m_logFile.size();
+	m_buffer.reserve(BUFFER_SIZE);
+	m_codec = QTextCodec::codecForName("UTF-8");
+	m_encoder = m_codec->makeEncoder(m_generateBom ? QTextCodec::DefaultConversion : QTextCodec::IgnoreHeader);
+}
+
+/*
+ * Destructor
+ */
+CLogWriter::~CLogWriter(void)
+{
+	const bool flushed = flush();
+	SAFE_DEL(m_encoder);
+	SAFE_DEL(m_index);
+
+	//All data has been written, so the journal is no longer needed (otherwise it is kept for recovery)
+	if(m_journal)
+	{
+		if(flushed)
+		{
+			m_journal->close();
+		}
+		SAFE_DEL(m_journal);
+	}
+}
+
+/*
+ * Start next record(s) (updates the index, if enabled)
+ */
+void CLogWriter::beginRecord(const qint64 timeStamp, const quint32 count)
+{
+	const quint64 record = m_records + 1;
+	m_records += count;
+
+	//Remember the oldest record that has not been synced yet
+	if(m_oldestPending < 0)
+	{
+		m_oldestPending = timeStamp;
+	}
+
+	if(m_index)
+	{
+		const qint64 currentOffset = offset();
+		if((record == 1) || (m_indexBytes && ((currentOffset - m_lastIndexOffset) >= m_indexBytes)) || (m_indexMSecs && ((timeStamp - m_lastIndexTime) >= m_indexMSecs)))
+		{
+			m_index->append(timeStamp, record, currentOffset);
+			m_lastIndexOffset = currentOffset;
+			m_lastIndexTime = timeStamp;
+		}
+	}
+}
+
+/*
+ * Append text to the log file
+ */
+void CLogWriter::write(const QString &text)
+{
+	const QByteArray data = m_encoder->fromUnicode(text);
+	append(data.constData(), data.size());
+}
+
+/*
+ * Append text that already is in the output encoding to the log file
+ */
+void CLogWriter::write(const char *data, const int len)
+{
+	//The BOM is generated by the encoder, so it must still see the very first chunk of data
+	if(m_generateBom && (offset() == 0))
+	{
+		const QByteArray header = m_encoder->fromUnicode(QString());
+		append(header.constData(), header.size());
+	}
+
+	append(data, len);
+}
+
+/*
+ * Append encoded data to the buffer (or the journal)
+ */
+void CLogWriter::append(const char *data, const int len)
+{
+	m_syncPending = true;
+
+	if(m_journal)
+	{
+		//Pending data is kept in the journal instead of the buffer
+		if(!m_journal->append(data, len))
+		{
+			if(!flush())
+			{
+				//The journal still holds data that could not be written, nothing can be added after it
+				m_failedBytes += len;
+				return;
+			}
+			if(!m_journal->append(data, len))
+			{
+				writeDirect(data, len);
+			}
+		}
+		if(m_journal->size() >= BUFFER_SIZE)
+		{
+			flush();
+		}
+		return;
+	}
+
+	m_buffer.append(data, len);
+
+	if(m_buffer.size() >= BUFFER_SIZE)
+	{
+		flush();
+	}
+}
+
+/*
+ * Flush the pending data to the log file, returns false if not all data could be written
+ */
+bool CLogWriter::flush(void)
+{
+	if(m_journal)
+	{
+		//Data must have reached the OS, before it is dropped from the journal
+		const int pendingSize = m_journal->size();
+		if(pendingSize > 0)
+		{
+			if(!writeAll(m_journal->data(), pendingSize, true))
+			{
+				return false;
+			}
+			m_journal->commit(m_fileOffset);
+		}
+		return true;
+	}
+
+	bool success = true;
+	if(!m_buffer.isEmpty())
+	{
+		if(!writeAll(m_buffer.constData(), m_buffer.size(), false))
+		{
+			m_failedBytes += m_buffer.size();
+			success = false;
+		}
+		m_buffer.resize(0);
+	}
+	return success;
+}
+
+/*
+ * Write data that does not fit into the journal (journal must be empty)
+ */
+void CLogWriter::writeDirect(const char *data, const int len)
+{
+	if(!writeAll(data, len, true))
+	{
+		m_failedBytes += len;
+		return;
+	}
+	m_journal->commit(m_fileOffset);
+}
+
+/*
+ * Write all data to the log file, a short write is rolled back if requested (so it can be retried or recovered from the journal)
+ */
+bool CLogWriter::writeAll(const char *data, const int len, const bool rollback)
+{
+	qint64 done = 0;
+	while(done < len)
+	{
+		const qint64 written = m_logFile.write(data + done, len - done);
+		if(written < 1)
+		{
+			break;
+		}
+		done += written;
+	}
+
+	const bool success = m_logFile.flush() && (done >= len);
+	if((!success) && rollback)
+	{
+		m_logFile.resize(m_fileOffset);
+		m_logFile.seek(m_fileOffset);
+		return false;
+	}
+
+	m_fileOffset += done;
+	return success;
+}
+
+/*
+ * Current offset in the log file, including pending data
+ */
+qint64 CLogWriter::offset(void) const
+{
+	return m_fileOffset + (m_journal ? m_journal->size() : m_buffer.size());
+}
+
+/*
+ * Make written records durable, according to the selected durability level
+ */
+void CLogWriter::commit(const bool force)
+{
+	switch(m_durability)
+	{
+	case DURABILITY_RECORD:
+		sync();
+		break;
+	case DURABILITY_INTERVAL:
+		if(force || ((QDateTime::currentMSecsSinceEpoch() - m_lastSyncTime) >= m_syncInterval))
+		{
+			sync();
+		}
+		break;
+	default:
+		if(force)
+		{
+			flush();
+		}
+		break;
+	}
+}
+
+/*
+ * Flush all pending data and wait until it has reached the disk
+ */
+bool CLogWriter::sync(void)
+{
+	const bool flushed = flush();
+
+	if(!m_syncPending)
+	{
+		return flushed;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	if(m_index)
+	{
+		m_index->flush();
+	}
+
+	bool success = flushed && m_logFile.flush();
+	const intptr_t osHandle = _get_osfhandle(m_logFile.handle());
+	if(success && (osHandle != -1))
+	{
+		success = (FlushFileBuffers(reinterpret_cast<HANDLE>(osHandle)) != FALSE);
+	}
+
+	//Update statistics
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	const qint64 duration = timer.nsecsElapsed() / 1000;
+	const qint64 latency = (m_oldestPending >= 0) ? qMax(now - m_oldestPending, Q_INT64_C(0)) : 0;
+	m_syncCount++;
+	m_syncTotalUSecs += duration;
+	m_syncMaxUSecs = qMax(m_syncMaxUSecs, duration);
+	m_latencyTotalMSecs += latency;
+	m_latencyMaxMSecs = qMax(m_latencyMaxMSecs, latency);
+
+	m_lastSyncTime = now;
+	m_oldestPending = -1;
+	m_syncPending = false;
+	return success;
+}
+
+/*
+ * Set output text encoding
+ */
+void CLogWriter::setCodec(QTextCodec *codec)
+{
+	//The BOM must be generated only for the very first chunk of data
+	const bool generateBom = m_generateBom && (offset() == 0);
+	SAFE_DEL(m_encoder);
+	m_codec = codec;
+	m_encoder = codec->makeEncoder(generateBom ? QTextCodec::DefaultConversion : QTextCodec::IgnoreHeader);
+}
+
+/*
+ * Enable the sidecar index
+ */
+bool CLogWriter::setIndex(const qint64 everyBytes, const qint64 everyMSecs)
+{
+	SAFE_DEL(m_index);
+
+	if((everyBytes <= 0) && (everyMSecs <= 0))
+	{
+		return true;
+	}
+
+	m_index = new CLogIndex(m_logFile.fileName());
+	if(!m_index->open(offset() == 0))
+	{
+		SAFE_DEL(m_index);
+		return false;
+	}
+
+	m_indexBytes = qMax(everyBytes, Q_INT64_C(0));
+	m_indexMSecs = qMax(everyMSecs, Q_INT64_C(0));
+	return true;
+}
+
+/*
+ * Select durability level (interval is used for DURABILITY_INTERVAL only)
+ * The sync is performed by the calling thread, so DURABILITY_RECORD blocks it for each record and the interval is limited to MIN_SYNC_INTERVAL
+ */
+void CLogWriter::setDurability(const Durability durability, const qint64 intervalMSecs)
+{
+	m_durability = durability;
+	m_syncInterval = qMax(intervalMSecs, MIN_SYNC_INTERVAL);
+	m_lastSyncTime = QDateTime::currentMSecsSinceEpoch();
+}
+
+/*
+ * Summary of sync durations and record-to-disk latencies
+ */
+QString CLogWriter::statistics(void) const
+{
+	static const char *names[] = { "none", "interval", "record" };
+
+	if(m_syncCount < 1)
+	{
+		return QString("Durability: %1, no syncs performed").arg(names[m_durability]);
+	}
+
+	const double avgSync = double(m_syncTotalUSecs) / double(m_syncCount) / 1000.0;
+	const double maxSync = double(m_syncMaxUSecs) / 1000.0;
+	const double avgLatency = double(m_latencyTotalMSecs) / double(m_syncCount);
+
+	return QString().sprintf("Durability: %s, %I64u syncs, sync time avg/max: %.3f/%.3f ms, record latency avg/max: %.1f/%I64d ms",
+		names[m_durability], m_syncCount, avgSync, maxSync, avgLatency, m_latencyMaxMSecs);
+}
+
+/*
+ * Enable the crash-safe journal for pending data
+ */
+bool CLogWriter::setJournal(const bool enable)
+{
+	flush();
+
+	if(m_journal)
+	{
+		m_journal->close();
+		SAFE_DEL(m_journal);
+	}
+
+	if(!enable)
+	{
+		return true;
+	}
+
+	m_journal = new CLogJournal(m_logFile.fileName());
+	if(!m_journal->open(m_fileOffset))
+	{
+		SAFE_DEL(m_journal);
+		return false;
+	}
+
+	m_buffer.clear();
+	return true;
+}
+
+/*
+ * Set text that is to be appended, if the log has to be recovered from the journal
+ */
+void CLogWriter::setFooter(const QString &footer)
+{
+	if(m_journal)
+	{
+		m_journal->setFooter(footer.isEmpty() ? QByteArray() : m_encoder->fromUnicode(footer));
+	}
+}
@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <QByteArray>
+
+//Forward declaration
+class QFile;
+class QString;
+class QTextCodec;
+class QTextEncoder;
+class CLogIndex;
+class CLogJournal;
+
+//Class CLogWriter
+class CLogWriter
+{
+public:
+	CLogWriter(QFile &logFile, const bool generateBom);
+	~CLogWriter(void);
+
+	//Types
+	typedef enum
+	{
+		DURABILITY_NONE = 0,
+		DURABILITY_INTERVAL = 1,
+		DURABILITY_RECORD = 2
+	}
+	Durability;
+
+	//Writing
+	void beginRecord(const qint64 timeStamp, const quint32 count = 1);
+	void write(const QString &text);
+	void write(const char *data, const int len);
+	bool flush(void);
+	void commit(const bool force = false);
+	bool sync(void);
+
+	//Setter methods
+	void setCodec(QTextCodec *codec);
+	bool setIndex(const qint64 everyBytes, const qint64 everyMSecs);
+	void setDurability(const Durability durability, const qint64 intervalMSecs);
+	bool setJournal(const bool enable);
+	void setFooter(const QString &footer);
+
+	//Getter methods
+	qint64 offset(void) const;
+	qint64 flushedOffset(void) const { return m_fileOffset; }
+	QTextCodec *codec(void) const { return m_codec; }
+	quint64 records(void) const { return m_records; }
+	Durability durability(void) const { return m_durability; }
+	qint64 syncInterval(void) const { return m_syncInterval; }
+	quint64 failedBytes(void) const { return m_failedBytes; }
+	QString statistics(void) const;
+
+private:
+	void append(const char *data, const int len);
+	void writeDirect(const char *data, const int len);
+	bool writeAll(const char *data, const int len, const bool rollback);
+
+	QFile &m_logFile;
+	QTextCodec *m_codec;
+	QTextEncoder *m_encoder;
+	QByteArray m_buffer;
+
+	const bool m_generateBom;
+	qint64 m_fileOffset;
+	quint64 m_records;
+
+	CLogIndex *m_index;
+	qint64 m_indexBytes;
+	qint64 m_indexMSecs;
+	qint64 m_lastIndexOffset;
+	qint64 m_lastIndexTime;
+
+	CLogJournal *m_journal;
+	quint64 m_failedBytes;
+
+	Durability m_durability;
+	qint64 m_syncInterval;
+	qint64 m_lastSyncTime;
+	qint64 m_oldestPending;
+	bool m_syncPending;
+
+	//Statistics
+	quint64 m_syncCount;
+	qint64 m_syncTotalUSecs;
+	qint64 m_syncMaxUSecs;
+	qint64 m_latencyTotalMSecs;
+	qint64 m_latencyMaxMSecs;
+};
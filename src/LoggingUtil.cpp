@@ -46,6 +46,11 @@
 //Internal
 #include "Version.h"
 #include "LogProcessor.h"
+#include "LogIndex.h"
+#include "LogJournal.h"
+#include "LogDaemon.h"
+#include "SeverityClassifier.h"
+#include "ConfigFile.h"
 
 //Version tags
 static const int VERSION_MAJOR = VER_LOGGER_MAJOR;
@@ -58,16 +63,59 @@ public:
 	bool printHelp;
 	QString childProgram;
 	QStringList childArgs;
+	QString inputFile;
+	QString followFile;
+	QString configFile;
+	QStringList configOverrides;
 	QString logFile;
 	bool captureStdout;
 	bool captureStderr;
 	bool enableSimplify;
 	bool appendLogFile;
-	CLogProcessor::Format format;
+	CLogFormatter::Format format;
+	bool preciseTime;
 	QString regExpKeep;
 	QString regExpSkip;
 	QString codecInp;
 	QString codecOut;
+	QString codecStdout;
+	QString codecStderr;
+	QString codecStdinp;
+	bool binaryDetect;
+	CBinaryFilter::Mode binaryMode;
+	QString binaryFile;
+	int maxLineLength;
+	int ptyColumns;
+	int ptyRows;
+	QString traceFile;
+	int traceSample;
+	int threadCount;
+	qint64 indexBytes;
+	qint64 indexMSecs;
+	CLogWriter::Durability durability;
+	qint64 syncInterval;
+	bool enableJournal;
+	qint64 maxRam;
+	qint64 maxSpill;
+	qint64 processStats;
+	int rateLimit;
+	int rateSample;
+	QString rateKeep;
+	QStringList sinkSpecs;
+	QStringList sinkFiles;
+	QStringList keywordSpecs;
+	QStringList extractNames;
+	QStringList extractRegExps;
+	qint64 extractInterval;
+	bool recoverMode;
+	bool daemonMode;
+	int daemonThreads;
+	bool connectDaemon;
+	QString pipeName;
+	bool queryMode;
+	QDateTime queryFrom;
+	QDateTime queryTo;
+	char queryChannel;
 };
 
 //Helper
@@ -76,17 +124,36 @@ public:
 
 //Forward declarations
 static bool parseArguments(int argc, wchar_t* argv[], parameters_t *parameters);
+static bool parseArgumentList(QStringList &list, parameters_t *parameters);
+static bool openLogFile(const parameters_t &parameters, QFile &logFile);
+static CLogProcessor *createProcessor(const parameters_t &parameters, QFile &logFile, void *inputHandle);
+static CLogProcessor *createSession(const QStringList &arguments, void *inputHandle, QFile *&logFile);
+static int runDaemon(const parameters_t &parameters);
+static int runClient(const parameters_t &parameters, int argc, wchar_t* argv[]);
 static void printUsage(void);
 static void printHeader(void);
 static QByteArray supportedCodecs(void);
+static bool parseGranularity(const QString &spec, qint64 &bytes, qint64 &msecs);
+static QDateTime parseDateTime(const QString &text);
+static bool parseDurability(const QString &spec, CLogWriter::Durability &durability, qint64 &intervalMSecs);
+static bool parseBinaryMode(const QString &spec, bool &detect, CBinaryFilter::Mode &mode);
+static bool parseSize(const QString &spec, qint64 &bytes);
+static bool parseSink(const QString &spec, quint32 &severityMask, CLogFormatter::Format &format, qint64 &rotateSize, bool &compress);
+static bool parseKeywords(const QString &spec, CSeverityClassifier::Severity &severity, QStringList &keywords);
 
 //Global variables
 QMutex giantLock;
 QCoreApplication *application = NULL;
 CLogProcessor *processor = NULL;
+CLogDaemon *daemon = NULL;
 
 //Const
 const char *STDIN_MARKER = "#STDIN#";
+const char *OFFLINE_MARKER = "^#OFFLINE:(.+)#$";
+const char *FOLLOW_MARKER = "^#FILE:(.+)#$";
+const char *DAEMON_PIPE_NAME = "LoggingUtil";
+const int DAEMON_THREADS = 4;
+const int DEFAULT_PTY_COLUMNS = 8192;
 
 /*
  * The Main function
@@ -122,8 +189,95 @@ static int logging_util_main(int argc, wchar_t* argv[])
 		return 0;
 	}
 
+	//Query an existing log file
+	if(parameters.queryMode)
+	{
+		if(!CLogIndex::query(parameters.logFile, parameters.queryFrom, parameters.queryTo, parameters.queryChannel, stdout))
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: Failed to query the log file! Is the index missing?\n\n");
+			fprintf(stderr, "Log file that was queried:\n%s\n\n", QFileInfo(parameters.logFile).absoluteFilePath().toUtf8().constData());
+			return -1;
+		}
+		return 0;
+	}
+
+	//Recover the journal of an existing log file
+	if(parameters.recoverMode)
+	{
+		qint64 recoveredBytes = 0, appendedBytes = 0;
+		if(!CLogJournal::exists(parameters.logFile))
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: There is no journal to recover for the log file! (journals of running processes are skipped)\n\n");
+			fprintf(stderr, "Journal files that could not be found:\n%s\n\n", QFileInfo(CLogJournal::journalFilePattern(parameters.logFile)).absoluteFilePath().toUtf8().constData());
+			return -1;
+		}
+		if(!CLogJournal::recover(parameters.logFile, recoveredBytes, appendedBytes))
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: Failed to recover the log file from the journal!\n\n");
+			fprintf(stderr, "Log file that was recovered:\n%s\n\n", QFileInfo(parameters.logFile).absoluteFilePath().toUtf8().constData());
+			return -1;
+		}
+		fprintf(stderr, "Recovered %I64d bytes of pending data into log file:\n%s\n\n", recoveredBytes, QFileInfo(parameters.logFile).absoluteFilePath().toUtf8().constData());
+		if(appendedBytes > 0)
+		{
+			fprintf(stderr, "WARNING: %I64d bytes could not be restored at their original position, they have been appended to the end!\n\n", appendedBytes);
+		}
+		return 0;
+	}
+
+	//Serve other instances of the logger
+	if(parameters.daemonMode)
+	{
+		return runDaemon(parameters);
+	}
+
+	//Forward STDIN to a running daemon
+	if(parameters.connectDaemon)
+	{
+		return runClient(parameters, argc, argv);
+	}
+
+	//Does input file exist?
+	if(!parameters.inputFile.isEmpty())
+	{
+		QFileInfo input(parameters.inputFile);
+
+		//Check for existence
+		if(!(input.exists() && input.isFile()))
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: The specified input file does not exist!\n\n");
+			fprintf(stderr, "Path that could not be found:\n%s\n\n", input.absoluteFilePath().toUtf8().constData());
+			return -1;
+		}
+
+		//Make absoloute path
+		parameters.inputFile = input.canonicalFilePath();
+	}
+
+	//Does followed file exist?
+	else if(!parameters.followFile.isEmpty())
+	{
+		QFileInfo input(parameters.followFile);
+
+		//Check for existence
+		if(!(input.exists() && input.isFile()))
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: The specified file to follow does not exist!\n\n");
+			fprintf(stderr, "Path that could not be found:\n%s\n\n", input.absoluteFilePath().toUtf8().constData());
+			return -1;
+		}
+
+		//Make absoloute path (the path is kept, as the file may be replaced by rotation)
+		parameters.followFile = input.absoluteFilePath();
+	}
+
 	//Does program file exist?
-	if(parameters.childProgram.compare(STDIN_MARKER, Qt::CaseInsensitive))
+	else if(parameters.childProgram.compare(STDIN_MARKER, Qt::CaseInsensitive))
 	{
 		QFileInfo program(parameters.childProgram);
 
@@ -142,12 +296,8 @@ static int logging_util_main(int argc, wchar_t* argv[])
 
 	//Open the log file
 	QFile logFile(parameters.logFile);
-	QIODevice::OpenMode openFlags = (parameters.appendLogFile) ? QIODevice::Append : (QIODevice::WriteOnly | QIODevice::Truncate);
-	if(!logFile.open(openFlags))
+	if(!openLogFile(parameters, logFile))
 	{
-		printHeader();
-		fprintf(stderr, "ERROR: Failed to open log file for writing!\n\n");
-		fprintf(stderr, "Path that failed to open is:\n%s\n\n", logFile.fileName().toUtf8().constData());
 		return -1;
 	}
 
@@ -156,29 +306,44 @@ static int logging_util_main(int argc, wchar_t* argv[])
 
 	//Create processor
 	QMutexLocker lock(&giantLock);
-	processor = new CLogProcessor(logFile);
+	processor = createProcessor(parameters, logFile, NULL);
 	lock.unlock();
 
-	//Setup parameters
-	processor->setCaptureStreams(parameters.captureStdout, parameters.captureStderr);
-	processor->setSimplifyStrings(parameters.enableSimplify);
-	processor->setFilterStrings(parameters.regExpKeep, parameters.regExpSkip);
-	processor->setOutputFormat(parameters.format);
-	
-	//Setup text encoding
-	if(!processor->setTextCodecs(QSTR2STR(parameters.codecInp), QSTR2STR(parameters.codecOut)))
+	if(!processor)
 	{
-		printHeader();
-		fprintf(stderr, "ERROR: The selected text Codec is invalid!\n\n");
-		fprintf(stderr, "Supported text codecs:\n%s\n\n", supportedCodecs().constData());
 		logFile.close();
-		delete processor;
 		delete application;
 		return -1;
 	}
 
-	//Try to start the child process (or STDIN reader)
-	if(parameters.childProgram.compare(STDIN_MARKER, Qt::CaseInsensitive))
+	//Try to start the child process (or STDIN reader, or file processing)
+	if(!parameters.inputFile.isEmpty())
+	{
+		if(!processor->startFileProcessing(parameters.inputFile))
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: Failed to open the input file!\n\n");
+			fprintf(stderr, "Path that failed to open is:\n%s\n\n", parameters.inputFile.toUtf8().constData());
+			logFile.close();
+			delete processor;
+			delete application;
+			return -1;
+		}
+	}
+	else if(!parameters.followFile.isEmpty())
+	{
+		if(!processor->startFileFollowing(parameters.followFile))
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: Failed to open the file to follow!\n\n");
+			fprintf(stderr, "Path that failed to open is:\n%s\n\n", parameters.followFile.toUtf8().constData());
+			logFile.close();
+			delete processor;
+			delete application;
+			return -1;
+		}
+	}
+	else if(parameters.childProgram.compare(STDIN_MARKER, Qt::CaseInsensitive))
 	{
 		if(!processor->startProcess(parameters.childProgram, parameters.childArgs))
 		{
@@ -220,6 +385,307 @@ static int logging_util_main(int argc, wchar_t* argv[])
 	return retval;
 }
 
+/*
+ * Recover a left-over journal and open the log file
+ */
+static bool openLogFile(const parameters_t &parameters, QFile &logFile)
+{
+	//Recover pending data that was left over by a previous session
+	if(parameters.appendLogFile && CLogJournal::exists(parameters.logFile))
+	{
+		qint64 recoveredBytes = 0, appendedBytes = 0;
+		if(!CLogJournal::recover(parameters.logFile, recoveredBytes, appendedBytes))
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: Failed to recover the journal of a previous session!\n\n");
+			fprintf(stderr, "Journal files that failed to recover:\n%s\n\n", QFileInfo(CLogJournal::journalFilePattern(parameters.logFile)).absoluteFilePath().toUtf8().constData());
+			return false;
+		}
+		if(appendedBytes > 0)
+		{
+			fprintf(stderr, "WARNING: %I64d bytes of a previous session could not be restored at their original position, they have been appended to the end!\n\n", appendedBytes);
+		}
+	}
+
+	//Open the log file
+	QIODevice::OpenMode openFlags = (parameters.appendLogFile) ? QIODevice::Append : (QIODevice::WriteOnly | QIODevice::Truncate);
+	if(!logFile.open(openFlags))
+	{
+		printHeader();
+		fprintf(stderr, "ERROR: Failed to open log file for writing!\n\n");
+		fprintf(stderr, "Path that failed to open is:\n%s\n\n", logFile.fileName().toUtf8().constData());
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Create and setup the processor for the log file
+ */
+static CLogProcessor *createProcessor(const parameters_t &parameters, QFile &logFile, void *inputHandle)
+{
+	//Create processor
+	CLogProcessor *logProcessor = new CLogProcessor(logFile, inputHandle);
+
+	//Setup parameters
+	logProcessor->setCaptureStreams(parameters.captureStdout, parameters.captureStderr);
+	logProcessor->setSimplifyStrings(parameters.enableSimplify);
+	logProcessor->setFilterStrings(parameters.regExpKeep, parameters.regExpSkip);
+	if(!logProcessor->setConfigFile(parameters.configFile, parameters.configOverrides))
+	{
+		printHeader();
+		fprintf(stderr, "ERROR: Failed to watch the config file!\n\n");
+		fprintf(stderr, "Path that failed to open is:\n%s\n\n", parameters.configFile.toUtf8().constData());
+		delete logProcessor;
+		return NULL;
+	}
+	logProcessor->setOutputFormat(parameters.format);
+	logProcessor->setPreciseTime(parameters.preciseTime);
+	logProcessor->setThreadCount(parameters.threadCount);
+	logProcessor->setDurability(parameters.durability, parameters.syncInterval);
+	logProcessor->setBufferLimits(parameters.maxRam, parameters.maxSpill);
+	logProcessor->setProcessStatistics(parameters.processStats);
+	logProcessor->setRateLimit(parameters.rateLimit, parameters.rateSample, parameters.rateKeep);
+	logProcessor->setMaxLineLength(parameters.maxLineLength);
+	logProcessor->setPseudoConsole(parameters.ptyColumns, parameters.ptyRows);
+
+	//Setup the latency tracing
+	if(!logProcessor->setTrace(parameters.traceFile, parameters.traceSample))
+	{
+		printHeader();
+		fprintf(stderr, "ERROR: Failed to open trace file for writing!\n\n");
+		fprintf(stderr, "Path that failed to open is:\n%s\n\n", parameters.traceFile.toUtf8().constData());
+		delete logProcessor;
+		return NULL;
+	}
+
+	//Setup the binary data handling
+	if(!logProcessor->setBinaryHandling(parameters.binaryDetect, parameters.binaryMode, parameters.binaryFile))
+	{
+		printHeader();
+		fprintf(stderr, "ERROR: Failed to open binary data file for writing!\n\n");
+		fprintf(stderr, "Path that failed to open is:\n%s\n\n", parameters.binaryFile.toUtf8().constData());
+		delete logProcessor;
+		return NULL;
+	}
+
+	//Setup the progress value extraction
+	if(!logProcessor->setExtractFields(parameters.extractNames, parameters.extractRegExps, parameters.extractInterval))
+	{
+		printHeader();
+		fprintf(stderr, "ERROR: Extraction RegExp is invalid! (must contain a capture, e.g. \"fps=([0-9.]+)\")\n\n");
+		delete logProcessor;
+		return NULL;
+	}
+
+	//Setup the severity keywords
+	for(int i = 0; i < parameters.keywordSpecs.count(); i++)
+	{
+		CSeverityClassifier::Severity severity;
+		QStringList keywords;
+		if(!(parseKeywords(parameters.keywordSpecs.at(i), severity, keywords) && logProcessor->setSeverityKeywords(severity, keywords)))
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: Severity keywords are invalid! (only ASCII keywords are supported)\n\n");
+			delete logProcessor;
+			return NULL;
+		}
+	}
+
+	//Setup the sinks
+	for(int i = 0; i < parameters.sinkSpecs.count(); i++)
+	{
+		quint32 severityMask = 0;
+		CLogFormatter::Format format = CLogFormatter::LOG_FORMAT_VERBOSE;
+		qint64 rotateSize = 0;
+		bool compress = false;
+		parseSink(parameters.sinkSpecs.at(i), severityMask, format, rotateSize, compress);
+		if(!logProcessor->addSink(parameters.sinkFiles.at(i), severityMask, format, rotateSize, compress, parameters.appendLogFile))
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: Failed to open sink file for writing!\n\n");
+			fprintf(stderr, "Path that failed to open is:\n%s\n\n", parameters.sinkFiles.at(i).toUtf8().constData());
+			delete logProcessor;
+			return NULL;
+		}
+	}
+
+	//Setup the sidecar index
+	if(!logProcessor->setIndexGranularity(parameters.indexBytes, parameters.indexMSecs))
+	{
+		printHeader();
+		fprintf(stderr, "ERROR: Failed to open index file for writing!\n\n");
+		fprintf(stderr, "Path that failed to open is:\n%s\n\n", CLogIndex::indexFileName(logFile.fileName()).toUtf8().constData());
+		delete logProcessor;
+		return NULL;
+	}
+
+	//Setup the crash-safe journal, only one process at a time may journal the log file
+	bool enableJournal = parameters.enableJournal;
+	if(enableJournal && CLogJournal::inUse(logFile.fileName()))
+	{
+		fprintf(stderr, "WARNING: The log file is journaled by another process, writing without journal!\n\n");
+		enableJournal = false;
+	}
+	if(!logProcessor->setJournal(enableJournal))
+	{
+		printHeader();
+		fprintf(stderr, "ERROR: Failed to create journal file!\n\n");
+		fprintf(stderr, "Path that failed to open is:\n%s\n\n", CLogJournal::journalFileName(logFile.fileName()).toUtf8().constData());
+		delete logProcessor;
+		return NULL;
+	}
+	
+	//Setup text encoding
+	bool codecsValid = logProcessor->setTextCodecs(QSTR2STR(parameters.codecInp), QSTR2STR(parameters.codecOut));
+	if(codecsValid && (!parameters.codecStdout.isEmpty())) codecsValid = logProcessor->setChannelCodec(CHANNEL_STDOUT, parameters.codecStdout.toLatin1().constData());
+	if(codecsValid && (!parameters.codecStderr.isEmpty())) codecsValid = logProcessor->setChannelCodec(CHANNEL_STDERR, parameters.codecStderr.toLatin1().constData());
+	if(codecsValid && (!parameters.codecStdinp.isEmpty())) codecsValid = logProcessor->setChannelCodec(CHANNEL_STDINP, parameters.codecStdinp.toLatin1().constData());
+	if(!codecsValid)
+	{
+		printHeader();
+		fprintf(stderr, "ERROR: The selected text Codec is invalid!\n\n");
+		fprintf(stderr, "Supported text codecs:\n%s\n\n", supportedCodecs().constData());
+		delete logProcessor;
+		return NULL;
+	}
+
+	return logProcessor;
+}
+
+/*
+ * Create a daemon session from the options that were sent by the client
+ */
+static CLogProcessor *createSession(const QStringList &arguments, void *inputHandle, QFile *&logFile)
+{
+	QStringList list(arguments);
+	parameters_t parameters;
+	if(!parseArgumentList(list, &parameters))
+	{
+		return NULL;
+	}
+
+	//Sessions can only log the data that is forwarded by the client
+	if(parameters.printHelp || parameters.queryMode || parameters.recoverMode || parameters.daemonMode || (!parameters.inputFile.isEmpty()) || parameters.childProgram.compare(STDIN_MARKER, Qt::CaseInsensitive))
+	{
+		return NULL;
+	}
+
+	//The thread pool is shared by all sessions, so a client must not resize it (sessions format on their event-loop thread)
+	parameters.threadCount = 0;
+
+	QFile *file = new QFile(parameters.logFile);
+	if(!openLogFile(parameters, *file))
+	{
+		delete file;
+		return NULL;
+	}
+
+	CLogProcessor *session = createProcessor(parameters, *file, inputHandle);
+	if(!session)
+	{
+		file->close();
+		delete file;
+		return NULL;
+	}
+
+	session->setEcho(false);
+	logFile = file;
+	return session;
+}
+
+/*
+ * Run the daemon until Ctrl+C is pressed
+ */
+static int runDaemon(const parameters_t &parameters)
+{
+	int dummy_argc = 1;
+	char *dummy_argv[] = { "program.exe", NULL };
+
+	//Create application
+	application = new QCoreApplication(dummy_argc, dummy_argv);
+
+	//Create daemon, sessions are distributed over a fixed number of event-loop threads
+	const int threadCount = (parameters.daemonThreads > 0) ? parameters.daemonThreads : DAEMON_THREADS;
+	QMutexLocker lock(&giantLock);
+	daemon = new CLogDaemon(createSession);
+	lock.unlock();
+
+	if(!daemon->start(parameters.pipeName, threadCount))
+	{
+		printHeader();
+		fprintf(stderr, "ERROR: Failed to create the pipe! Is another daemon running already?\n\n");
+		fprintf(stderr, "Pipe that failed to create is:\n%s\n\n", CLogDaemon::pipePath(parameters.pipeName).toUtf8().constData());
+		lock.relock();
+		SAFE_DEL(daemon);
+		SAFE_DEL(application);
+		return -1;
+	}
+
+	printHeader();
+	fprintf(stderr, "Daemon is listening on %s (%d threads), press Ctrl+C to stop...\n\n", CLogDaemon::pipePath(parameters.pipeName).toUtf8().constData(), threadCount);
+
+	//Now run event loop
+	int retval = application->exec();
+
+	//Clean up
+	lock.relock();
+	SAFE_DEL(daemon);
+	SAFE_DEL(application);
+	lock.unlock();
+
+	return retval;
+}
+
+/*
+ * Forward STDIN to the daemon, which creates the log on behalf of this instance
+ */
+static int runClient(const parameters_t &parameters, int argc, wchar_t* argv[])
+{
+	if(parameters.childProgram.compare(STDIN_MARKER, Qt::CaseInsensitive))
+	{
+		printHeader();
+		fprintf(stderr, "ERROR: Option '--connect' can only be used with #STDIN#!\n\n");
+		fprintf(stderr, "Please type \"LoggingUtil.exe --help :\" for details...\n\n");
+		return -1;
+	}
+
+	//The daemon parses the same options, but it may be running in a different directory
+	QStringList arguments;
+	for(int i = 1; i < argc; i++)
+	{
+		arguments << QString::fromUtf16(reinterpret_cast<const ushort*>(argv[i])).trimmed();
+	}
+	const int marker = (arguments.indexOf(":") < 0) ? arguments.count() : arguments.indexOf(":");
+	for(int i = 0; (i + 2) < marker; i++)
+	{
+		if(!arguments.at(i).compare("--sink", Qt::CaseInsensitive))
+		{
+			arguments[i + 2] = QFileInfo(arguments.at(i + 2)).absoluteFilePath();
+		}
+	}
+	for(int i = 0; (i + 1) < marker; i++)
+	{
+		if(!arguments.at(i).compare("--config", Qt::CaseInsensitive))
+		{
+			arguments[i + 1] = QFileInfo(arguments.at(i + 1)).absoluteFilePath();
+		}
+	}
+	arguments.insert(marker, QFileInfo(parameters.logFile).absoluteFilePath());
+	arguments.insert(marker, "--logfile");
+
+	if(!CLogDaemon::forward(parameters.pipeName, arguments))
+	{
+		printHeader();
+		fprintf(stderr, "ERROR: Failed to forward the data to the daemon! Is the daemon running?\n\n");
+		fprintf(stderr, "Pipe that failed to connect is:\n%s\n\n", CLogDaemon::pipePath(parameters.pipeName).toUtf8().constData());
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * Make sure there is one more argument
  */
@@ -239,40 +705,114 @@ while(0)
  * Parse the CLI args
  */
 static bool parseArguments(int argc, wchar_t* argv[], parameters_t *parameters)
+{
+	//Convert all parameters to QString's
+	QStringList list;
+	for(int i = 1; i < argc; i++)
+	{
+		list << QString::fromUtf16(reinterpret_cast<const ushort*>(argv[i])).trimmed();
+	}
+
+	return parseArgumentList(list, parameters);
+}
+
+/*
+ * Parse the list of args (also used for the options sent to the daemon)
+ */
+static bool parseArgumentList(QStringList &list, parameters_t *parameters)
 {
 	//Setup defaults
 	parameters->printHelp = false;
 	parameters->childProgram.clear();
 	parameters->childArgs.clear();
+	parameters->inputFile.clear();
+	parameters->followFile.clear();
+	parameters->configFile.clear();
+	parameters->configOverrides.clear();
 	parameters->logFile.clear();
 	parameters->captureStdout = true;
 	parameters->captureStderr = true;
 	parameters->enableSimplify = true;
 	parameters->appendLogFile = true;
-	parameters->format = CLogProcessor::LOG_FORMAT_VERBOSE;
+	parameters->format = CLogFormatter::LOG_FORMAT_VERBOSE;
+	parameters->preciseTime = false;
 	parameters->regExpKeep.clear();
 	parameters->regExpSkip.clear();
 	parameters->codecInp.clear();
 	parameters->codecOut.clear();
+	parameters->codecStdout.clear();
+	parameters->codecStderr.clear();
+	parameters->codecStdinp.clear();
+	parameters->binaryDetect = false;
+	parameters->binaryMode = CBinaryFilter::BINARY_SUMMARY;
+	parameters->binaryFile.clear();
+	parameters->maxLineLength = 0;
+	parameters->ptyColumns = 0;
+	parameters->ptyRows = 25;
+	parameters->traceFile.clear();
+	parameters->traceSample = 100;
+	parameters->threadCount = 0;
+	parameters->indexBytes = 0;
+	parameters->indexMSecs = 0;
+	parameters->durability = CLogWriter::DURABILITY_NONE;
+	parameters->syncInterval = 0;
+	parameters->enableJournal = false;
+	parameters->maxRam = Q_INT64_C(64) << 20;
+	parameters->maxSpill = 0;
+	parameters->processStats = -1;
+	parameters->rateLimit = 0;
+	parameters->rateSample = 100;
+	parameters->rateKeep.clear();
+	parameters->sinkSpecs.clear();
+	parameters->sinkFiles.clear();
+	parameters->keywordSpecs.clear();
+	parameters->extractNames.clear();
+	parameters->extractRegExps.clear();
+	parameters->extractInterval = 10000;
+	parameters->recoverMode = false;
+	parameters->daemonMode = false;
+	parameters->daemonThreads = 0;
+	parameters->connectDaemon = false;
+	parameters->pipeName = DAEMON_PIPE_NAME;
+	parameters->queryMode = false;
+	parameters->queryFrom = QDateTime();
+	parameters->queryTo = QDateTime();
+	parameters->queryChannel = '\0';
 
 	//Make sure user has set parameters
-	if(argc < 2)
+	if(list.isEmpty())
 	{
 		parameters->printHelp = true;
 		return true;
 	}
 
-	//Convert all parameters to QString's
-	QStringList list;
-	for(int i = 1; i < argc; i++)
+	const QString OPTION_MARKER = ":";
+
+	//Options from the config file go first, so they can be overridden on the command line
+	for(int i = 0; ((i + 1) < list.count()) && list.at(i).compare(OPTION_MARKER, Qt::CaseInsensitive); i++)
 	{
-		list << QString::fromUtf16(reinterpret_cast<const ushort*>(argv[i])).trimmed();
+		if(!list.at(i).compare("--config", Qt::CaseInsensitive))
+		{
+			CConfigFile config(list.at(i + 1));
+			if(!config.load())
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Failed to read the config file!\n\n");
+				fprintf(stderr, "Path that failed to open is:\n%s\n\n", config.fileName().toUtf8().constData());
+				return false;
+			}
+			if(!list.contains(OPTION_MARKER))
+			{
+				list << OPTION_MARKER << config.input();
+			}
+			parameters->configOverrides = list.mid(0, list.indexOf(OPTION_MARKER));
+			list = config.options() + list;
+			break;
+		}
 	}
 
-	const QString OPTION_MARKER = ":";
-
-	//Have logger options?
-	bool bHaveOptions = false;
+	//Have logger options? (query, recover and daemon mode take options only)
+	bool bHaveOptions = (!list.first().compare("--query", Qt::CaseInsensitive)) || (!list.first().compare("--recover", Qt::CaseInsensitive)) || (!list.first().compare("--daemon", Qt::CaseInsensitive));
 	for(QStringList::ConstIterator iter = list.constBegin(); iter != list.constEnd(); iter++)
 	{
 		if(!(*iter).compare(OPTION_MARKER, Qt::CaseInsensitive))
@@ -344,13 +884,21 @@ static bool parseArguments(int argc, wchar_t* argv[], parameters_t *parameters)
 		}
 		else if(!current.compare("--plain-output", Qt::CaseInsensitive))
 		{
-			parameters->format = CLogProcessor::LOG_FORMAT_PLAIN;
+			parameters->format = CLogFormatter::LOG_FORMAT_PLAIN;
 		}
 		else if(!current.compare("--html-output", Qt::CaseInsensitive))
 		{
-			parameters->format = CLogProcessor::LOG_FORMAT_HTML;
+			parameters->format = CLogFormatter::LOG_FORMAT_HTML;
 			parameters->appendLogFile = false;
 		}
+		else if(!current.compare("--json-output", Qt::CaseInsensitive))
+		{
+			parameters->format = CLogFormatter::LOG_FORMAT_JSON;
+		}
+		else if(!current.compare("--precise-time", Qt::CaseInsensitive))
+		{
+			parameters->preciseTime = true;
+		}
 		else if(!current.compare("--no-append", Qt::CaseInsensitive))
 		{
 			parameters->appendLogFile = false;
@@ -375,6 +923,289 @@ static bool parseArguments(int argc, wchar_t* argv[], parameters_t *parameters)
 			CHECK_NEXT_ARGUMENT(list, "--codec-out");
 			parameters->codecOut = list.takeFirst();
 		}
+		else if(!current.compare("--codec-stdout", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--codec-stdout");
+			parameters->codecStdout = list.takeFirst();
+		}
+		else if(!current.compare("--codec-stderr", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--codec-stderr");
+			parameters->codecStderr = list.takeFirst();
+		}
+		else if(!current.compare("--codec-stdin", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--codec-stdin");
+			parameters->codecStdinp = list.takeFirst();
+		}
+		else if(!current.compare("--binary", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--binary");
+			if(!parseBinaryMode(list.takeFirst(), parameters->binaryDetect, parameters->binaryMode))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Binary mode is invalid! (must be \"summary\", \"hex\", \"base64\" or \"off\")\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--binary-file", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--binary-file");
+			parameters->binaryFile = QFileInfo(list.takeFirst()).absoluteFilePath();
+		}
+		else if(!current.compare("--max-line", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--max-line");
+			bool ok = false;
+			parameters->maxLineLength = list.takeFirst().toInt(&ok);
+			if((!ok) || (parameters->maxLineLength < 0))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Maximum line length is invalid!\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--pty", Qt::CaseInsensitive))
+		{
+			parameters->ptyColumns = qMax(parameters->ptyColumns, DEFAULT_PTY_COLUMNS);
+		}
+		else if(!current.compare("--pty-size", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--pty-size");
+			QRegExp rx("^(\\d+)x(\\d+)$", Qt::CaseInsensitive);
+			if(rx.indexIn(list.takeFirst().trimmed()) < 0)
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Pseudo console size is invalid! (example: \"8192x25\")\n\n");
+				return false;
+			}
+			parameters->ptyColumns = qBound(1, rx.cap(1).toInt(), 32767);
+			parameters->ptyRows = qBound(1, rx.cap(2).toInt(), 32767);
+		}
+		else if(!current.compare("--trace", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--trace");
+#ifdef NO_LATENCY_TRACE
+			printHeader();
+			fprintf(stderr, "ERROR: Tracing is not supported by this build!\n\n");
+			return false;
+#else
+			parameters->traceFile = QFileInfo(list.takeFirst()).absoluteFilePath();
+#endif //NO_LATENCY_TRACE
+		}
+		else if(!current.compare("--trace-sample", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--trace-sample");
+			bool ok = false;
+			parameters->traceSample = list.takeFirst().toInt(&ok);
+			if((!ok) || (parameters->traceSample < 1))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Trace sampling rate is invalid!\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--threads", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--threads");
+			bool ok = false;
+			parameters->threadCount = list.takeFirst().toInt(&ok);
+			if((!ok) || (parameters->threadCount < 0))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Number of threads is invalid!\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--index", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--index");
+			if(!parseGranularity(list.takeFirst(), parameters->indexBytes, parameters->indexMSecs))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Index granularity is invalid! (examples: \"64K\", \"1s\", \"1M,500ms\")\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--durability", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--durability");
+			if(!parseDurability(list.takeFirst(), parameters->durability, parameters->syncInterval))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Durability level is invalid! (examples: \"none\", \"interval:500\", \"record\")\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--journal", Qt::CaseInsensitive))
+		{
+			parameters->enableJournal = true;
+		}
+		else if(!current.compare("--max-ram", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--max-ram");
+			if(!parseSize(list.takeFirst(), parameters->maxRam))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Memory limit is invalid! (examples: \"65536\", \"512K\", \"64M\", \"1G\")\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--max-spill", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--max-spill");
+			if(!parseSize(list.takeFirst(), parameters->maxSpill))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Spill file limit is invalid! (examples: \"0\", \"512M\", \"4G\")\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--recover", Qt::CaseInsensitive))
+		{
+			parameters->recoverMode = true;
+		}
+		else if(!current.compare("--process-stats", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--process-stats");
+			bool ok = false;
+			parameters->processStats = list.takeFirst().toLongLong(&ok);
+			if((!ok) || (parameters->processStats < 0))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Statistics interval is invalid!\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--rate-limit", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--rate-limit");
+			bool ok = false;
+			parameters->rateLimit = list.takeFirst().toInt(&ok);
+			if((!ok) || (parameters->rateLimit < 0))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Rate limit is invalid!\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--rate-sample", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--rate-sample");
+			bool ok = false;
+			parameters->rateSample = list.takeFirst().toInt(&ok);
+			if((!ok) || (parameters->rateSample < 0))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Sampling rate is invalid!\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--rate-keep", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--rate-keep");
+			parameters->rateKeep = list.takeFirst();
+		}
+		else if(!current.compare("--extract", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--extract");
+			parameters->extractNames << list.takeFirst();
+			CHECK_NEXT_ARGUMENT(list, "--extract");
+			parameters->extractRegExps << list.takeFirst();
+		}
+		else if(!current.compare("--extract-interval", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--extract-interval");
+			bool ok = false;
+			parameters->extractInterval = list.takeFirst().toLongLong(&ok);
+			if((!ok) || (parameters->extractInterval < 1))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Extraction interval is invalid!\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--sink", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--sink");
+			const QString spec = list.takeFirst();
+			CHECK_NEXT_ARGUMENT(list, "--sink");
+			quint32 severityMask = 0;
+			CLogFormatter::Format format = CLogFormatter::LOG_FORMAT_VERBOSE;
+			qint64 rotateSize = 0;
+			bool compress = false;
+			if(!parseSink(spec, severityMask, format, rotateSize, compress))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Sink specification is invalid! (examples: \"error,warning\", \"info,json,100M,gz\")\n\n");
+				return false;
+			}
+			parameters->sinkSpecs << spec;
+			parameters->sinkFiles << list.takeFirst();
+		}
+		else if(!current.compare("--config", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--config");
+			parameters->configFile = QFileInfo(list.takeFirst()).absoluteFilePath();
+		}
+		else if(!current.compare("--keywords", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--keywords");
+			CSeverityClassifier::Severity severity;
+			QStringList keywords;
+			parameters->keywordSpecs << list.takeFirst();
+			if(!parseKeywords(parameters->keywordSpecs.last(), severity, keywords))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Severity keywords are invalid! (example: \"error:error,fatal,failed\")\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--daemon", Qt::CaseInsensitive))
+		{
+			parameters->daemonMode = true;
+		}
+		else if(!current.compare("--connect", Qt::CaseInsensitive))
+		{
+			parameters->connectDaemon = true;
+		}
+		else if(!current.compare("--pipe", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--pipe");
+			parameters->pipeName = list.takeFirst();
+		}
+		else if(!current.compare("--daemon-threads", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--daemon-threads");
+			bool ok = false;
+			parameters->daemonThreads = list.takeFirst().toInt(&ok);
+			if((!ok) || (parameters->daemonThreads < 1))
+			{
+				printHeader();
+				fprintf(stderr, "ERROR: Number of daemon threads is invalid!\n\n");
+				return false;
+			}
+		}
+		else if(!current.compare("--query", Qt::CaseInsensitive))
+		{
+			parameters->queryMode = true;
+		}
+		else if(!current.compare("--from", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--from");
+			parameters->queryFrom = parseDateTime(list.takeFirst());
+		}
+		else if(!current.compare("--to", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--to");
+			parameters->queryTo = parseDateTime(list.takeFirst());
+		}
+		else if(!current.compare("--channel", Qt::CaseInsensitive))
+		{
+			CHECK_NEXT_ARGUMENT(list, "--channel");
+			const QString channel = list.takeFirst().toUpper();
+			parameters->queryChannel = channel.isEmpty() ? '\0' : channel.at(0).toLatin1();
+		}
 		else
 		{
 			printHeader();
@@ -384,6 +1215,54 @@ static bool parseArguments(int argc, wchar_t* argv[], parameters_t *parameters)
 		}
 	}
 
+	//Daemon takes no further parameters
+	if(parameters->daemonMode)
+	{
+		if(parameters->threadCount > 0)
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: Daemon mode does not support '--threads', use '--daemon-threads' instead!\n\n");
+			fprintf(stderr, "Please type \"LoggingUtil.exe --help :\" for details...\n\n");
+			return false;
+		}
+		return true;
+	}
+
+	//Check recover parameters
+	if(parameters->recoverMode)
+	{
+		if(parameters->logFile.isEmpty())
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: Recover mode requires a valid '--logfile'!\n\n");
+			fprintf(stderr, "Please type \"LoggingUtil.exe --help :\" for details...\n\n");
+			return false;
+		}
+		return true;
+	}
+
+	//Check query parameters
+	if(parameters->queryMode)
+	{
+		if(parameters->logFile.isEmpty() || (!parameters->queryFrom.isValid()) || (!parameters->queryTo.isValid()))
+		{
+			printHeader();
+			fprintf(stderr, "ERROR: Query mode requires a valid '--logfile', '--from' and '--to'!\n\n");
+			fprintf(stderr, "Please type \"LoggingUtil.exe --help :\" for details...\n\n");
+			return false;
+		}
+		return true;
+	}
+
+	//A pseudo console has a single output stream, STDERR can not be told apart from STDOUT
+	if((parameters->ptyColumns > 0) && (!parameters->captureStdout))
+	{
+		printHeader();
+		fprintf(stderr, "ERROR: Option '--only-stderr' can not be used with '--pty', the pseudo console merges STDERR into STDOUT!\n\n");
+		fprintf(stderr, "Please type \"LoggingUtil.exe --help :\" for details...\n\n");
+		return false;
+	}
+
 	//Check child process program name
 	if(list.isEmpty() || list.first().isEmpty())
 	{
@@ -400,11 +1279,31 @@ static bool parseArguments(int argc, wchar_t* argv[], parameters_t *parameters)
 		parameters->childArgs << list.takeFirst();
 	}
 
+	//Process an existing file?
+	QRegExp offline(OFFLINE_MARKER, Qt::CaseInsensitive);
+	if(offline.indexIn(parameters->childProgram) >= 0)
+	{
+		parameters->inputFile = offline.cap(1);
+	}
+
+	//Follow a growing file?
+	QRegExp follow(FOLLOW_MARKER, Qt::CaseInsensitive);
+	if(follow.indexIn(parameters->childProgram) >= 0)
+	{
+		parameters->followFile = follow.cap(1);
+	}
+
 	//Generate log file name
 	if(parameters->logFile.isEmpty())
 	{
-		const QString ext = (parameters->format == CLogProcessor::LOG_FORMAT_HTML) ? "htm" : "log";
-		if(parameters->childProgram.compare(STDIN_MARKER, Qt::CaseInsensitive))
+		const QString ext = (parameters->format == CLogFormatter::LOG_FORMAT_HTML) ? "htm" : ((parameters->format == CLogFormatter::LOG_FORMAT_JSON) ? "json" : "log");
+		if((!parameters->inputFile.isEmpty()) || (!parameters->followFile.isEmpty()))
+		{
+			QFileInfo info(parameters->inputFile.isEmpty() ? parameters->followFile : parameters->inputFile);
+			QRegExp rx("[^a-zA-Z0-9_]");
+			parameters->logFile = QString("%1.%2.%3").arg(info.completeBaseName().replace(rx, "_"), QDateTime::currentDateTime().toString("yyyy-MM-dd"), ext);
+		}
+		else if(parameters->childProgram.compare(STDIN_MARKER, Qt::CaseInsensitive))
 		{
 			QFileInfo info(parameters->childProgram);
 			QRegExp rx("[^a-zA-Z0-9_]");
@@ -446,6 +1345,12 @@ static void printUsage(void)
 	fprintf(stderr, "  SomeProgram.exe [parameters] | LoggingUtil.exe [options] : #STDIN#\n");
 	fprintf(stderr, "  SomeProgram.exe [parameters] 2>&1 | LoggingUtil.exe [options] : #STDIN#\n");
 	fprintf(stderr, "\n");
+	fprintf(stderr, "Usage Mode #3:\n");
+	fprintf(stderr, "  LoggingUtil.exe [options] : #OFFLINE:<input file>#\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Usage Mode #4:\n");
+	fprintf(stderr, "  LoggingUtil.exe [options] : #FILE:<file written by another program>#\n");
+	fprintf(stderr, "\n");
 	fprintf(stderr, "Logging Options:\n");
 	fprintf(stderr, "  --logfile <logfile>  Specifies the output log file (appends if file exists)\n");
 	fprintf(stderr, "  --only-stdout        Capture only output from STDOUT, ignores STDERR\n");
@@ -454,14 +1359,65 @@ static void printUsage(void)
 	fprintf(stderr, "  --no-append          Do NOT append, i.e. any existing log content is lost\n");
 	fprintf(stderr, "  --plain-output       Create less verbose logging output\n");
 	fprintf(stderr, "  --html-output        Create HTML logging output, implies NO append\n");
+	fprintf(stderr, "  --json-output        Create JSON logging output (one object per line)\n");
+	fprintf(stderr, "  --precise-time       Include microseconds in the logged time stamps\n");
 	fprintf(stderr, "  --regexp-keep <exp>  Keep ONLY strings that match the given RegExp\n");
 	fprintf(stderr, "  --regexp-skip <exp>  Skip all the strings that match the given RegExp\n");
 	fprintf(stderr, "  --codec-in <name>    Setup the input text encoding (default: \"UTF-8\")\n");
 	fprintf(stderr, "  --codec-out <name>   Setup the output text encoding (default: \"UTF-8\")\n");
+	fprintf(stderr, "  --codec-stdout <name> Force the encoding of STDOUT (default: auto-detect or --codec-in)\n");
+	fprintf(stderr, "  --codec-stderr <name> Force the encoding of STDERR (default: auto-detect or --codec-in)\n");
+	fprintf(stderr, "  --codec-stdin <name> Force the encoding of STDIN/file input (default: auto-detect or --codec-in)\n");
+	fprintf(stderr, "  --binary <mode>      Binary data is logged as: summary, hex, base64 or off (default: off)\n");
+	fprintf(stderr, "  --binary-file <file> Append the binary data to a side file, summaries give the offset\n");
+	fprintf(stderr, "  --max-line <chars>   Split lines longer than N characters (default: 0 = unlimited)\n");
+	fprintf(stderr, "  --pty                Run the program on a pseudo console, so it does not buffer its output\n");
+	fprintf(stderr, "                       STDERR is merged into STDOUT, so '--only-stderr' is not supported\n");
+	fprintf(stderr, "  --pty-size <WxH>     Size of the pseudo console, implies --pty (default: 8192x25)\n");
+	fprintf(stderr, "  --trace <file>       Write the latency of the processing stages as Chrome trace JSON\n");
+	fprintf(stderr, "  --trace-sample <n>   Trace every N-th chunk of input (default: 100)\n");
+	fprintf(stderr, "  --threads <count>    Filter and format on worker threads (default: 0 = off)\n");
+	fprintf(stderr, "  --index <every>      Write sidecar index every N bytes and/or N (milli)seconds\n");
+	fprintf(stderr, "  --durability <mode>  Sync log to disk: none, interval:<ms> (min. 100) or record (default: none)\n");
+	fprintf(stderr, "  --journal            Keep pending data in a crash-safe journal (<logfile>.<pid>.jnl)\n");
+	fprintf(stderr, "  --max-ram <size>     Buffer at most this much STDIN data in memory (default: 64M)\n");
+	fprintf(stderr, "  --max-spill <size>   Spill at most this much STDIN data to disk (default: 0 = no limit)\n");
+	fprintf(stderr, "  --process-stats <ms> Log CPU, memory and I/O usage of the process (0 = totals only)\n");
+	fprintf(stderr, "  --rate-limit <lines> Keep at most N lines per second and channel (default: 0 = off)\n");
+	fprintf(stderr, "  --rate-sample <k>    Keep every K-th line above the rate limit (default: 100)\n");
+	fprintf(stderr, "  --rate-keep <exp>    Always keep lines that match the given RegExp, e.g. \"error|fatal\"\n");
+	fprintf(stderr, "  --extract <name> <exp> Summarize values captured by RegExp, instead of logging the lines\n");
+	fprintf(stderr, "  --extract-interval <ms> Interval of the value summaries (default: 10000)\n");
+	fprintf(stderr, "  --sink <spec> <file> Also write lines of the given severities to a separate file\n");
+	fprintf(stderr, "                       spec: info|warning|error|all [,plain|verbose|json] [,<rotate size>] [,gz]\n");
+	fprintf(stderr, "  --config <file>      Read options from file, filters and format are reloaded on change\n");
+	fprintf(stderr, "  --keywords <list>    Set the keywords of a severity, e.g. \"warning:warn,deprecated\"\n");
+	fprintf(stderr, "  --connect            Forward STDIN to a running daemon, which writes the log\n");
+	fprintf(stderr, "  --pipe <name>        Name of the daemon's pipe (default: \"LoggingUtil\")\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Query Mode:\n");
+	fprintf(stderr, "  LoggingUtil.exe --query --logfile <logfile> --from <time> --to <time> [--channel <id>]\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Recover Mode:\n");
+	fprintf(stderr, "  LoggingUtil.exe --recover --logfile <logfile>\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Daemon Mode:\n");
+	fprintf(stderr, "  LoggingUtil.exe --daemon [--pipe <name>] [--daemon-threads <count>]\n");
+	fprintf(stderr, "  Sessions are spread over the daemon threads, each session writes its log on its own thread\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Config File:\n");
+	fprintf(stderr, "  One option per line, e.g. \"regexp-skip = ^frame\" or \"sink = error errors.log\"\n");
+	fprintf(stderr, "  Flags are set by \"true\", the input by \"program = <file>\" and \"arguments = <list>\"\n");
 	fprintf(stderr, "\n");
 	fprintf(stderr, "Examples:\n");
 	fprintf(stderr, "  LoggingUtil.exe --logfile x264_log.txt : x264.exe -o output.mkv input.avs\n");
 	fprintf(stderr, "  x264.exe -o output.mkv input.avs 2>&1 | LoggingUtil.exe : #STDIN#\n");
+	fprintf(stderr, "  x264.exe -o output.mkv input.avs 2>&1 | LoggingUtil.exe --connect : #STDIN#\n");
+	fprintf(stderr, "  LoggingUtil.exe --config encode.ini\n");
+	fprintf(stderr, "  LoggingUtil.exe --logfile service.log : #FILE:C:\\Service\\Logs\\service.txt#\n");
+	fprintf(stderr, "  LoggingUtil.exe --extract fps \"([0-9.]+) fps\" --extract kbps \"([0-9.]+) kb/s\" : x264.exe -o output.mkv input.avs\n");
+	fprintf(stderr, "  LoggingUtil.exe --sink error,warning errors.log --sink info,json,100M,gz bulk.json.gz : x264.exe -o output.mkv input.avs\n");
+	fprintf(stderr, "  LoggingUtil.exe --query --logfile x264_log.txt --from 2013-01-01T12:00:00 --to 2013-01-01T12:05:00\n");
 	fprintf(stderr, "\n");
 }
 
@@ -476,6 +1432,164 @@ static QByteArray supportedCodecs(void)
 	return list.join(", ").toLatin1();
 }
 
+/*
+ * Parse index granularity, e.g. "64K", "1s" or "1M,500ms"
+ */
+static bool parseGranularity(const QString &spec, qint64 &bytes, qint64 &msecs)
+{
+	const QStringList parts = spec.split(',', QString::SkipEmptyParts);
+	QRegExp rx("^(\\d+)(k|m|ms|s)?$", Qt::CaseInsensitive);
+
+	foreach(const QString &part, parts)
+	{
+		if(rx.indexIn(part.trimmed()) < 0)
+		{
+			return false;
+		}
+
+		const qint64 value = rx.cap(1).toLongLong();
+		const QString unit = rx.cap(2).toLower();
+
+		if(unit.isEmpty())    bytes = value;
+		else if(unit == "k")  bytes = value << 10;
+		else if(unit == "m")  bytes = value << 20;
+		else if(unit == "ms") msecs = value;
+		else if(unit == "s")  msecs = value * 1000;
+	}
+
+	return (!parts.isEmpty());
+}
+
+/*
+ * Parse date and time, e.g. "2013-01-01T12:00:00" or "2013-01-01 12:00:00"
+ */
+static QDateTime parseDateTime(const QString &text)
+{
+	QString iso(text.trimmed());
+	return QDateTime::fromString(iso.replace(' ', 'T'), Qt::ISODate);
+}
+
+/*
+ * Parse durability level, e.g. "none", "interval:500" or "record"
+ */
+static bool parseDurability(const QString &spec, CLogWriter::Durability &durability, qint64 &intervalMSecs)
+{
+	QRegExp rx("^interval(:(\\d+))?$", Qt::CaseInsensitive);
+	const QString mode = spec.trimmed();
+
+	if(!mode.compare("none", Qt::CaseInsensitive))
+	{
+		durability = CLogWriter::DURABILITY_NONE;
+		return true;
+	}
+	if(!mode.compare("record", Qt::CaseInsensitive))
+	{
+		durability = CLogWriter::DURABILITY_RECORD;
+		return true;
+	}
+	if(rx.indexIn(mode) >= 0)
+	{
+		durability = CLogWriter::DURABILITY_INTERVAL;
+		intervalMSecs = rx.cap(2).isEmpty() ? 1000 : rx.cap(2).toLongLong();
+		return (intervalMSecs > 0);
+	}
+
+	return false;
+}
+
+/*
+ * Parse binary data mode, e.g. "summary", "hex", "base64" or "off"
+ */
+static bool parseBinaryMode(const QString &spec, bool &detect, CBinaryFilter::Mode &mode)
+{
+	const QString value = spec.trimmed();
+	detect = true;
+
+	if(!value.compare("summary", Qt::CaseInsensitive))
+	{
+		mode = CBinaryFilter::BINARY_SUMMARY;
+		return true;
+	}
+	if(!value.compare("hex", Qt::CaseInsensitive))
+	{
+		mode = CBinaryFilter::BINARY_HEX;
+		return true;
+	}
+	if(!value.compare("base64", Qt::CaseInsensitive))
+	{
+		mode = CBinaryFilter::BINARY_BASE64;
+		return true;
+	}
+	if((!value.compare("off", Qt::CaseInsensitive)) || (!value.compare("none", Qt::CaseInsensitive)))
+	{
+		detect = false;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Parse size in bytes, e.g. "65536", "512K", "64M" or "1G"
+ */
+static bool parseSize(const QString &spec, qint64 &bytes)
+{
+	QRegExp rx("^(\\d+)(k|m|g)?$", Qt::CaseInsensitive);
+	if(rx.indexIn(spec.trimmed()) < 0)
+	{
+		return false;
+	}
+
+	const qint64 value = rx.cap(1).toLongLong();
+	const QString unit = rx.cap(2).toLower();
+
+	if(unit.isEmpty())   bytes = value;
+	else if(unit == "k") bytes = value << 10;
+	else if(unit == "m") bytes = value << 20;
+	else if(unit == "g") bytes = value << 30;
+
+	return true;
+}
+
+/*
+ * Parse sink specification, e.g. "error,warning" or "info,json,100M,gz"
+ */
+static bool parseSink(const QString &spec, quint32 &severityMask, CLogFormatter::Format &format, qint64 &rotateSize, bool &compress)
+{
+	const QStringList tokens = spec.split(',', QString::SkipEmptyParts);
+
+	foreach(const QString &token, tokens)
+	{
+		const QString name = token.trimmed().toLower();
+		CSeverityClassifier::Severity severity;
+
+		if(CSeverityClassifier::parseSeverity(name, severity)) severityMask |= (1U << severity);
+		else if(name == "all")     severityMask |= ((1U << CSeverityClassifier::SEVERITY_COUNT) - 1U);
+		else if(name == "plain")   format = CLogFormatter::LOG_FORMAT_PLAIN;
+		else if(name == "verbose") format = CLogFormatter::LOG_FORMAT_VERBOSE;
+		else if(name == "json")    format = CLogFormatter::LOG_FORMAT_JSON;
+		else if(name == "gz")      compress = true;
+		else if(!parseSize(name, rotateSize)) return false;
+	}
+
+	return (severityMask != 0);
+}
+
+/*
+ * Parse severity keywords, e.g. "error:error,fatal,failed"
+ */
+static bool parseKeywords(const QString &spec, CSeverityClassifier::Severity &severity, QStringList &keywords)
+{
+	const int separator = spec.indexOf(':');
+	if((separator < 0) || (!CSeverityClassifier::parseSeverity(spec.left(separator), severity)))
+	{
+		return false;
+	}
+
+	keywords = spec.mid(separator + 1).split(',', QString::SkipEmptyParts);
+	return (severity != CSeverityClassifier::SEVERITY_INFO);
+}
+
 /*
  * Ctrl+C handler routine
  */
@@ -488,6 +1602,11 @@ static BOOL WINAPI ctrlHandlerRoutine(DWORD dwCtrlType)
 		QTimer::singleShot(0, processor, SLOT(forceQuit()));
 	}
 
+	if(daemon)
+	{
+		QTimer::singleShot(0, daemon, SLOT(shutdown()));
+	}
+
 	return TRUE;
 }
 
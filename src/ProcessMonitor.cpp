@@ -0,0 +1,157 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "ProcessMonitor.h"
+
+//Windows
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <Psapi.h>
+
+//CRT
+#include <cstring>
+
+//Internal
+#include "LogFormatter.h"
+
+//Helper
+#define MBYTES(X) (double(X) / 1048576.0)
+
+//Forward declarations
+static qint64 fileTimeToUSecs(const FILETIME &fileTime);
+
+/*
+ * Constructor
+ */
+CProcessMonitor::CProcessMonitor(void *processHandle)
+:
+	m_processHandle(processHandle),
+	m_psapi(NULL),
+	m_getMemoryInfo(NULL),
+	m_startTime(CLogFormatter::currentTime()),
+	m_peakWorkingSet(0)
+{
+	memset(&m_current, 0, sizeof(counters_t));
+	m_current.wallTime = m_startTime;
+	m_previous = m_current;
+
+	//Psapi.dll is loaded only when statistics are enabled
+	if(HMODULE psapi = LoadLibraryW(L"Psapi.dll"))
+	{
+		m_psapi = psapi;
+		m_getMemoryInfo = (FunGetProcessMemoryInfo) GetProcAddress(psapi, "GetProcessMemoryInfo");
+	}
+}
+
+/*
+ * Destructor
+ */
+CProcessMonitor::~CProcessMonitor(void)
+{
+	if(m_psapi)
+	{
+		FreeLibrary(static_cast<HMODULE>(m_psapi));
+	}
+}
+
+/*
+ * Statistics since the previous sample
+ */
+QString CProcessMonitor::sample(void)
+{
+	m_previous = m_current;
+	if(!update())
+	{
+		return QString();
+	}
+
+	const qint64 elapsed = qMax(m_current.wallTime - m_previous.wallTime, Q_INT64_C(1));
+	const qint64 cpuTime = (m_current.userTime + m_current.kernelTime) - (m_previous.userTime + m_previous.kernelTime);
+
+	return QString().sprintf("Process statistics: CPU %.1f%%, working set %.1f MB, private %.1f MB, read %.1f MB, written %.1f MB, page faults %u",
+		100.0 * double(cpuTime) / double(elapsed), MBYTES(m_current.workingSet), MBYTES(m_current.privateBytes),
+		MBYTES(m_current.readBytes - m_previous.readBytes), MBYTES(m_current.writeBytes - m_previous.writeBytes), m_current.pageFaults - m_previous.pageFaults);
+}
+
+/*
+ * Totals for the whole lifetime of the process (call after it has terminated)
+ */
+QString CProcessMonitor::totals(void)
+{
+	update();
+
+	const double elapsed = double(qMax(m_current.wallTime - m_startTime, Q_INT64_C(1))) / 1000000.0;
+	const double userTime = double(m_current.userTime) / 1000000.0;
+	const double kernelTime = double(m_current.kernelTime) / 1000000.0;
+
+	return QString().sprintf("Process totals: wall time %.3f s, CPU user %.3f s, kernel %.3f s (%.1f%%), peak working set %.1f MB, read %.1f MB (%I64u ops), written %.1f MB (%I64u ops)",
+		elapsed, userTime, kernelTime, 100.0 * (userTime + kernelTime) / elapsed, MBYTES(m_peakWorkingSet),
+		MBYTES(m_current.readBytes), m_current.readOps, MBYTES(m_current.writeBytes), m_current.writeOps);
+}
+
+/*
+ * Query the current counters of the process
+ */
+bool CProcessMonitor::update(void)
+{
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if(!GetProcessTimes(m_processHandle, &creationTime, &exitTime, &kernelTime, &userTime))
+	{
+		return false;
+	}
+
+	m_current.wallTime = CLogFormatter::currentTime();
+	m_current.userTime = fileTimeToUSecs(userTime);
+	m_current.kernelTime = fileTimeToUSecs(kernelTime);
+
+	PROCESS_MEMORY_COUNTERS memoryCounters;
+	if(m_getMemoryInfo && m_getMemoryInfo(m_processHandle, &memoryCounters, sizeof(PROCESS_MEMORY_COUNTERS)))
+	{
+		m_current.workingSet = memoryCounters.WorkingSetSize;
+		m_current.privateBytes = memoryCounters.PagefileUsage;
+		m_current.pageFaults = memoryCounters.PageFaultCount;
+		m_peakWorkingSet = qMax(m_peakWorkingSet, quint64(memoryCounters.PeakWorkingSetSize));
+	}
+
+	IO_COUNTERS ioCounters;
+	if(GetProcessIoCounters(m_processHandle, &ioCounters))
+	{
+		m_current.readBytes = ioCounters.ReadTransferCount;
+		m_current.writeBytes = ioCounters.WriteTransferCount;
+		m_current.readOps = ioCounters.ReadOperationCount;
+		m_current.writeOps = ioCounters.WriteOperationCount;
+	}
+
+	return true;
+}
+
+// ===================================================
+// Misc Stuff
+// ===================================================
+
+/*
+ * Convert FILETIME duration (100 ns units) to microseconds
+ */
+static qint64 fileTimeToUSecs(const FILETIME &fileTime)
+{
+	return qint64((quint64(fileTime.dwHighDateTime) << 32) | quint64(fileTime.dwLowDateTime)) / 10;
+}
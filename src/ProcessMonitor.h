@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QString>
+
+//Typedef
+typedef int (__stdcall *FunGetProcessMemoryInfo)(void *hProcess, void *ppsmemCounters, unsigned long cb);
+
+//Class CProcessMonitor
+//Samples CPU time, memory and I/O counters of the child process (plain Win32 queries, no allocations per sample)
+class CProcessMonitor
+{
+public:
+	CProcessMonitor(void *processHandle);
+	~CProcessMonitor(void);
+
+	QString sample(void);
+	QString totals(void);
+
+private:
+	CProcessMonitor(const CProcessMonitor&);
+	CProcessMonitor &operator=(const CProcessMonitor&);
+
+	typedef struct
+	{
+		qint64 wallTime;   //microseconds
+		qint64 userTime;   //microseconds
+		qint64 kernelTime; //microseconds
+		quint64 workingSet;
+		quint64 privateBytes;
+		quint32 pageFaults;
+		quint64 readBytes;
+		quint64 writeBytes;
+		quint64 readOps;
+		quint64 writeOps;
+	}
+	counters_t;
+
+	bool update(void);
+
+	void *const m_processHandle;
+	void *m_psapi;
+	FunGetProcessMemoryInfo m_getMemoryInfo;
+
+	const qint64 m_startTime;
+	counters_t m_current;
+	counters_t m_previous;
+	quint64 m_peakWorkingSet;
+};
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "RateLimiter.h"
+
+//Qt
+#include <QStringList>
+
+//Internal
+#include "LogFormatter.h"
+
+//CRT
+#include <cstring>
+
+//Const
+static const qint64 ONE_LINE = 1000000;
+static const qint64 SUMMARY_INTERVAL = 10000000;
+
+/*
+ * Constructor
+ */
+CRateLimiter::CRateLimiter(const quint32 linesPerSecond, const quint32 sampleEvery)
+:
+	m_linesPerSecond(qMax(linesPerSecond, 1U)),
+	m_sampleEvery(sampleEvery),
+	m_droppedTotal(0),
+	m_lastSummary(0)
+{
+	memset(m_buckets, 0, sizeof(m_buckets));
+	for(int i = 0; i < MAX_CHANNELS; i++)
+	{
+		m_buckets[i].tokens = m_linesPerSecond * ONE_LINE;
+		m_buckets[i].lastRefill = -1;
+	}
+}
+
+/*
+ * Check whether the line is to be kept (system messages are never dropped)
+ */
+bool CRateLimiter::accept(const QChar *data, const int len, const int channel, const qint64 timeStamp)
+{
+	if(channel == CHANNEL_SYSMSG)
+	{
+		return true;
+	}
+
+	bucket_t &bucket = m_buckets[channelIndex(channel)];
+
+	//Refill the bucket, it never holds more than one second worth of lines
+	if(bucket.lastRefill >= 0)
+	{
+		const qint64 elapsed = qMax(timeStamp - bucket.lastRefill, Q_INT64_C(0));
+		bucket.tokens = qMin(bucket.tokens + (elapsed * m_linesPerSecond), m_linesPerSecond * ONE_LINE);
+	}
+	bucket.lastRefill = timeStamp;
+
+	if(bucket.tokens >= ONE_LINE)
+	{
+		bucket.tokens -= ONE_LINE;
+		bucket.sampleCounter = 0;
+		return true;
+	}
+
+	//Over the limit: keep every K-th line
+	if((m_sampleEvery > 0) && ((bucket.sampleCounter++ % m_sampleEvery) == 0))
+	{
+		return true;
+	}
+
+	//Priority lines are always kept, the pattern is only evaluated for lines that would be dropped
+	if(!m_regExpPriority.isEmpty())
+	{
+		m_view.setRawData(data, len);
+		if(m_regExpPriority.indexIn(m_view) >= 0)
+		{
+			return true;
+		}
+	}
+
+	bucket.dropped++;
+	m_droppedTotal++;
+	return false;
+}
+
+/*
+ * Lines have been dropped and the last summary is old enough
+ */
+bool CRateLimiter::isSummaryDue(const qint64 timeStamp) const
+{
+	return (m_droppedTotal > 0) && ((timeStamp - m_lastSummary) >= SUMMARY_INTERVAL);
+}
+
+/*
+ * Summary of the lines dropped since the last summary (counters are reset)
+ */
+QString CRateLimiter::takeSummary(const qint64 timeStamp)
+{
+	static const char *const names[] = { "STDOUT", "STDERR", "STDIN", "FILE" };
+	static const int channels[] = { CHANNEL_STDOUT, CHANNEL_STDERR, CHANNEL_STDINP, CHANNEL_FILE };
+
+	QStringList details;
+	for(int i = 0; i < 4; i++)
+	{
+		bucket_t &bucket = m_buckets[channelIndex(channels[i])];
+		if(bucket.dropped > 0)
+		{
+			details << QString("%1: %2").arg(QString::fromLatin1(names[i]), QString::number(bucket.dropped));
+			bucket.dropped = 0;
+		}
+	}
+
+	const QString summary = QString("Rate limit exceeded, %1 lines have been dropped (%2)").arg(QString::number(m_droppedTotal), details.join(", "));
+	m_droppedTotal = 0;
+	m_lastSummary = timeStamp;
+	return summary;
+}
+
+/*
+ * Set regular expression for lines that are always kept
+ */
+void CRateLimiter::setPriority(const QString &regExp)
+{
+	m_regExpPriority = regExp.isEmpty() ? QRegExp() : QRegExp(regExp, Qt::CaseInsensitive);
+}
+
+/*
+ * Bucket index for the channel flag
+ */
+int CRateLimiter::channelIndex(const int channel)
+{
+	int index = 0;
+	while((index < (MAX_CHANNELS - 1)) && (!(channel & (1 << index)))) index++;
+	return index;
+}
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QString>
+#include <QRegExp>
+
+//Class CRateLimiter
+//Token bucket per channel: N lines per second pass, after that only every K-th line and lines matching the priority pattern
+class CRateLimiter
+{
+public:
+	CRateLimiter(const quint32 linesPerSecond, const quint32 sampleEvery);
+
+	//Line processing (time stamps are in microseconds since the epoch)
+	bool accept(const QChar *data, const int len, const int channel, const qint64 timeStamp);
+
+	//Summary of dropped lines
+	bool isSummaryDue(const qint64 timeStamp) const;
+	bool hasDroppedLines(void) const { return m_droppedTotal > 0; }
+	QString takeSummary(const qint64 timeStamp);
+
+	//Setter methods
+	void setPriority(const QString &regExp);
+
+private:
+	static const int MAX_CHANNELS = 8;
+
+	typedef struct
+	{
+		qint64 tokens;     //in millionths of a line
+		qint64 lastRefill; //microseconds
+		quint32 sampleCounter;
+		quint64 dropped;
+	}
+	bucket_t;
+
+	static int channelIndex(const int channel);
+
+	const qint64 m_linesPerSecond;
+	const quint32 m_sampleEvery;
+
+	QRegExp m_regExpPriority;
+	QString m_view;
+
+	bucket_t m_buckets[MAX_CHANNELS];
+	quint64 m_droppedTotal;
+	qint64 m_lastSummary;
+};
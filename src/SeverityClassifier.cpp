@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "SeverityClassifier.h"
+
+//Qt
+#include <QQueue>
+
+//Const
+static const char *const SEVERITY_NAMES[] = { "info", "warning", "error" };
+static const char *const DEFAULT_WARNING = "warn,deprecated";
+static const char *const DEFAULT_ERROR = "error,fatal,failed,failure,exception,critical,panic";
+
+/*
+ * Constructor
+ */
+CSeverityClassifier::CSeverityClassifier(void)
+:
+	m_compiled(false)
+{
+	m_keywords[SEVERITY_WARNING] = QString::fromLatin1(DEFAULT_WARNING).split(',');
+	m_keywords[SEVERITY_ERROR] = QString::fromLatin1(DEFAULT_ERROR).split(',');
+}
+
+/*
+ * Find the highest severity of all keywords that occur in the line
+ */
+CSeverityClassifier::Severity CSeverityClassifier::classify(const QChar *data, const int len)
+{
+	if(!m_compiled)
+	{
+		compile();
+	}
+
+	const int *const transitions = m_transitions.constData();
+	const int *const severities = m_severities.constData();
+
+	int state = 0, result = SEVERITY_INFO;
+	for(int i = 0; i < len; i++)
+	{
+		const ushort c = data[i].unicode();
+		if(c >= ALPHABET_SIZE)
+		{
+			state = 0;
+			continue;
+		}
+
+		state = transitions[(state * ALPHABET_SIZE) + (((c >= 'A') && (c <= 'Z')) ? (c + 32) : c)];
+		if(severities[state] > result)
+		{
+			result = severities[state];
+			if(result == (SEVERITY_COUNT - 1))
+			{
+				break;
+			}
+		}
+	}
+
+	return Severity(result);
+}
+
+/*
+ * Replace the keywords of the given severity (ASCII only)
+ */
+bool CSeverityClassifier::setKeywords(const Severity severity, const QStringList &keywords)
+{
+	QStringList list;
+	foreach(const QString &keyword, keywords)
+	{
+		const QString trimmed = keyword.trimmed();
+		for(int i = 0; i < trimmed.length(); i++)
+		{
+			if(trimmed.at(i).unicode() >= ALPHABET_SIZE)
+			{
+				return false;
+			}
+		}
+		if(!trimmed.isEmpty())
+		{
+			list << trimmed.toLower();
+		}
+	}
+
+	m_keywords[severity] = list;
+	m_compiled = false;
+	return true;
+}
+
+/*
+ * Severity from its name ("info", "warning" or "error")
+ */
+bool CSeverityClassifier::parseSeverity(const QString &name, Severity &severity)
+{
+	for(int i = 0; i < SEVERITY_COUNT; i++)
+	{
+		if(!name.trimmed().compare(QString::fromLatin1(SEVERITY_NAMES[i]), Qt::CaseInsensitive))
+		{
+			severity = Severity(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Build the automaton: keyword trie first, then failure links are folded into the transition table
+ */
+void CSeverityClassifier::compile(void)
+{
+	m_transitions.fill(-1, ALPHABET_SIZE);
+	m_severities.fill(-1, 1);
+
+	for(int severity = 0; severity < SEVERITY_COUNT; severity++)
+	{
+		foreach(const QString &keyword, m_keywords[severity])
+		{
+			int state = 0;
+			for(int i = 0; i < keyword.length(); i++)
+			{
+				const int c = keyword.at(i).toLower().unicode();
+				if(m_transitions[(state * ALPHABET_SIZE) + c] < 0)
+				{
+					m_transitions[(state * ALPHABET_SIZE) + c] = m_severities.count();
+					m_transitions.insert(m_transitions.count(), ALPHABET_SIZE, -1);
+					m_severities.append(-1);
+				}
+				state = m_transitions[(state * ALPHABET_SIZE) + c];
+			}
+			m_severities[state] = qMax(m_severities[state], severity);
+		}
+	}
+
+	//Breadth-first, so the failure state has always been completed before
+	QVector<int> failure(m_severities.count(), 0);
+	QQueue<int> queue;
+
+	for(int c = 0; c < ALPHABET_SIZE; c++)
+	{
+		int &next = m_transitions[c];
+		if(next < 0)
+		{
+			next = 0;
+		}
+		else
+		{
+			queue.enqueue(next);
+		}
+	}
+
+	while(!queue.isEmpty())
+	{
+		const int state = queue.dequeue();
+		m_severities[state] = qMax(m_severities[state], m_severities[failure[state]]);
+
+		for(int c = 0; c < ALPHABET_SIZE; c++)
+		{
+			const int fallback = m_transitions[(failure[state] * ALPHABET_SIZE) + c];
+			int &next = m_transitions[(state * ALPHABET_SIZE) + c];
+			if(next < 0)
+			{
+				next = fallback;
+			}
+			else
+			{
+				failure[next] = fallback;
+				queue.enqueue(next);
+			}
+		}
+	}
+
+	m_compiled = true;
+}
@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//Class CSeverityClassifier
+//Tags lines with a severity, all keywords are matched in a single pass (Aho-Corasick automaton, ASCII keywords, case-insensitive)
+class CSeverityClassifier
+{
+public:
+	CSeverityClassifier(void);
+
+	//Types
+	typedef enum
+	{
+		SEVERITY_INFO = 0,
+		SEVERITY_WARNING = 1,
+		SEVERITY_ERROR = 2
+	}
+	Severity;
+
+	static const int SEVERITY_COUNT = 3;
+
+	//Line processing
+	Severity classify(const QChar *data, const int len);
+
+	//Setter methods
+	bool setKeywords(const Severity severity, const QStringList &keywords);
+
+	//Misc
+	static bool parseSeverity(const QString &name, Severity &severity);
+
+private:
+	static const int ALPHABET_SIZE = 128;
+
+	void compile(void);
+
+	QStringList m_keywords[SEVERITY_COUNT];
+	bool m_compiled;
+
+	QVector<int> m_transitions; //complete DFA, ALPHABET_SIZE entries per state
+	QVector<int> m_severities;  //highest severity of all keywords ending in the state (or -1)
+};
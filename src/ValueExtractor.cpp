@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "ValueExtractor.h"
+
+//Qt
+#include <QStringList>
+
+/*
+ * Constructor
+ */
+CValueExtractor::CValueExtractor(const qint64 intervalMSecs)
+:
+	m_interval(qMax(intervalMSecs, Q_INT64_C(1)) * 1000),
+	m_windowStart(-1),
+	m_lines(0)
+{
+}
+
+/*
+ * Extract the values from a line, the line is consumed if any field matches
+ */
+bool CValueExtractor::process(const QChar *data, const int len, const qint64 timeStamp)
+{
+	bool consumed = false;
+	m_view.setRawData(data, len);
+
+	for(int i = 0; i < m_fields.count(); i++)
+	{
+		field_t &field = m_fields[i];
+		if(field.regExp.indexIn(m_view) < 0)
+		{
+			continue;
+		}
+
+		bool ok = false;
+		const double value = field.regExp.cap(1).toDouble(&ok);
+		if(ok)
+		{
+			field.minValue = (field.count > 0) ? qMin(field.minValue, value) : value;
+			field.maxValue = (field.count > 0) ? qMax(field.maxValue, value) : value;
+			field.sumValue += value;
+			field.count++;
+		}
+		consumed = true;
+	}
+
+	if(consumed)
+	{
+		if(m_windowStart < 0)
+		{
+			m_windowStart = timeStamp;
+		}
+		m_lines++;
+	}
+
+	return consumed;
+}
+
+/*
+ * Values have been collected and the window is complete
+ */
+bool CValueExtractor::isSummaryDue(const qint64 timeStamp) const
+{
+	return (m_lines > 0) && ((timeStamp - m_windowStart) >= m_interval);
+}
+
+/*
+ * Summary of the current window, a new window is started
+ */
+QString CValueExtractor::takeSummary(const qint64 timeStamp)
+{
+	QStringList values;
+	for(int i = 0; i < m_fields.count(); i++)
+	{
+		field_t &field = m_fields[i];
+		if(field.count > 0)
+		{
+			values << QString().sprintf("%s min/avg/max %.2f/%.2f/%.2f", field.name.toUtf8().constData(), field.minValue, field.sumValue / double(field.count), field.maxValue);
+		}
+		field.count = 0;
+		field.sumValue = 0.0;
+	}
+
+	const double duration = double(qMax(timeStamp - m_windowStart, Q_INT64_C(0))) / 1000000.0;
+	const QString summary = QString().sprintf("Progress (%.1f s, %u lines): ", duration, m_lines) + (values.isEmpty() ? QString("no values") : values.join(", "));
+
+	m_windowStart = -1;
+	m_lines = 0;
+	return summary;
+}
+
+/*
+ * Add a field, the first capture of the regular expression is the value
+ */
+bool CValueExtractor::addField(const QString &name, const QString &regExp)
+{
+	field_t field;
+	field.name = name;
+	field.regExp = QRegExp(regExp);
+	field.count = 0;
+	field.minValue = field.maxValue = field.sumValue = 0.0;
+
+	if((!field.regExp.isValid()) || (field.regExp.captureCount() < 1))
+	{
+		return false;
+	}
+
+	m_fields.append(field);
+	return true;
+}
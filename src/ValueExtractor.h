@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QString>
+#include <QRegExp>
+#include <QList>
+
+//Class CValueExtractor
+//Pulls numeric fields out of progress lines and condenses them into periodic min/avg/max summaries
+class CValueExtractor
+{
+public:
+	CValueExtractor(const qint64 intervalMSecs);
+
+	//Line processing (time stamps are in microseconds since the epoch), returns true if the line has been consumed
+	bool process(const QChar *data, const int len, const qint64 timeStamp);
+
+	//Summary of the current window
+	bool isSummaryDue(const qint64 timeStamp) const;
+	bool hasValues(void) const { return m_lines > 0; }
+	QString takeSummary(const qint64 timeStamp);
+
+	//Setter methods
+	bool addField(const QString &name, const QString &regExp);
+
+private:
+	typedef struct
+	{
+		QString name;
+		QRegExp regExp;
+		quint32 count;
+		double minValue;
+		double maxValue;
+		double sumValue;
+	}
+	field_t;
+
+	const qint64 m_interval; //microseconds
+
+	QList<field_t> m_fields;
+	QString m_view;
+
+	qint64 m_windowStart;
+	quint32 m_lines;
+};
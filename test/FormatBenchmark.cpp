@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "FormatBenchmark.h"
+
+//Internal
+#include "../src/LogFormatter.h"
+#include "../src/LineBatch.h"
+
+//Qt
+#include <QStringList>
+#include <QtTest>
+
+//Const
+static const int LINES_PER_ITERATION = 1000;
+
+//Meta types
+Q_DECLARE_METATYPE(CLogFormatter::Format)
+
+/*
+ * Typical encoder progress and status lines, some with redundant whitespace
+ */
+void CFormatBenchmark::initTestCase(void)
+{
+	for(int i = 0; i < LINES_PER_ITERATION; i++)
+	{
+		switch(i % 4)
+		{
+		case 0:
+			m_lines << QString("[%1.0%] %2/5000 frames, 24.31 fps, 1873.52 kb/s, eta 0:01:52").arg(i / 10).arg(i);
+			break;
+		case 1:
+			m_lines << QString("x264 [info]:   frame I:%1     Avg QP:18.25  size: 81290").arg(i);
+			break;
+		case 2:
+			m_lines << QString("\t  warning: <buffer> underflow & \"retry\" at position %1  ").arg(i * 4096);
+			break;
+		default:
+			m_lines << QString::fromUtf8("encoded %1 frames \xC3\xA4\xC3\xB6\xC3\xBC \xE4\xB8\xAD\xE6\x96\x87").arg(i);
+			break;
+		}
+	}
+}
+
+/*
+ * All specializations of the batch function, plus the simplification that runs when lines are added
+ */
+void CFormatBenchmark::formatLines_data(void)
+{
+	QTest::addColumn<CLogFormatter::Format>("format");
+	QTest::addColumn<bool>("simplify");
+	QTest::addColumn<bool>("filter");
+	QTest::addColumn<bool>("precise");
+
+	static const char *const names[] = { "plain", "verbose", "html", "json" };
+	static const CLogFormatter::Format formats[] = { CLogFormatter::LOG_FORMAT_PLAIN, CLogFormatter::LOG_FORMAT_VERBOSE, CLogFormatter::LOG_FORMAT_HTML, CLogFormatter::LOG_FORMAT_JSON };
+
+	for(int f = 0; f < 4; f++)
+	{
+		for(int flags = 0; flags < 8; flags++)
+		{
+			const bool simplify = ((flags & 1) != 0), filter = ((flags & 2) != 0), precise = ((flags & 4) != 0);
+			const QByteArray name = QString("%1%2%3%4").arg(names[f], simplify ? ",simplify" : "", filter ? ",filter" : "", precise ? ",precise" : "").toLatin1();
+			QTest::newRow(name.constData()) << formats[f] << simplify << filter << precise;
+		}
+	}
+}
+
+/*
+ * The result per iteration in milliseconds equals the cost per line in microseconds
+ */
+void CFormatBenchmark::formatLines(void)
+{
+	QFETCH(CLogFormatter::Format, format);
+	QFETCH(bool, simplify);
+	QFETCH(bool, filter);
+	QFETCH(bool, precise);
+
+	CLogFormatter formatter;
+	formatter.setFormat(format);
+	formatter.setSimplify(simplify);
+	formatter.setPreciseTime(precise);
+	formatter.setFilter(filter ? QString("frame") : QString(), filter ? QString("^x264") : QString());
+
+	CLineBatch batch;
+	const qint64 timeStamp = CLogFormatter::currentTime();
+
+	QBENCHMARK
+	{
+		batch.reset();
+		for(int i = 0; i < LINES_PER_ITERATION; i++)
+		{
+			batch.append(m_lines.at(i).constData(), m_lines.at(i).length(), (i & 1) ? CHANNEL_STDERR : CHANNEL_STDOUT, timeStamp + i, formatter.isSimplifyEnabled());
+		}
+		batch.format(formatter);
+	}
+
+	QVERIFY(!batch.output().isEmpty());
+}
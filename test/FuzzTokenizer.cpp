@@ -0,0 +1,116 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+//Fuzz target for the tokenizer (libFuzzer), it is not part of the test project
+//The lines must not depend on how the input is split into chunks
+//Build it with clang-cl and "-fsanitize=fuzzer,address", together with all sources of "src" (except LoggingUtil.cpp), the MOC files and QtCore
+
+//Internal
+#include "../src/LogProcessor.h"
+
+//Qt
+#include <QCoreApplication>
+#include <QTemporaryFile>
+#include <QList>
+
+//CRT
+#include <cstdlib>
+
+//Const
+static const size_t MAX_INPUT_SIZE = 65536;
+
+//Class CTokenizerFuzzer
+//Runs the processor on the fuzzer's input, has access to its private members
+class CTokenizerFuzzer
+{
+public:
+	static QByteArray tokenize(const QList<QByteArray> &chunks, const bool simplify);
+};
+
+/*
+ * Feed the chunks to the processor (plain format, so the log contains nothing but the lines)
+ */
+QByteArray CTokenizerFuzzer::tokenize(const QList<QByteArray> &chunks, const bool simplify)
+{
+	QTemporaryFile logFile;
+	if(!logFile.open())
+	{
+		abort();
+	}
+
+	{
+		CLogProcessor processor(logFile);
+		processor.setOutputFormat(CLogFormatter::LOG_FORMAT_PLAIN);
+		processor.setSimplifyStrings(simplify);
+		processor.initializeLog();
+		for(int i = 0; i < chunks.count(); i++)
+		{
+			processor.processData(chunks.at(i), CHANNEL_STDOUT);
+		}
+		processor.flushBuffers();
+		processor.finishLog();
+	}
+
+	logFile.seek(0);
+	return logFile.readAll();
+}
+
+/*
+ * The processor needs an application object for its event loop
+ */
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+	static QCoreApplication application(*argc, *argv);
+	return 0;
+}
+
+/*
+ * The first byte selects simplification and seeds the chunk sizes, the other bytes are the input
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uchar *data, size_t size)
+{
+	if((size < 1) || (size > MAX_INPUT_SIZE))
+	{
+		return 0;
+	}
+
+	const bool simplify = ((data[0] & 0x80) != 0);
+	const QByteArray input(reinterpret_cast<const char*>(data + 1), int(size - 1));
+
+	//The processor holds back the head of the stream, so neither the detected codec nor the BOM depend on the chunk sizes
+	QList<QByteArray> chunks;
+	quint32 seed = data[0];
+	for(int pos = 0; pos < input.size();)
+	{
+		seed = (seed * 1103515245U) + 12345U;
+		const int len = int((seed >> 16) % 67U);
+		chunks << input.mid(pos, len);
+		pos += len;
+	}
+
+	if(tokenize(chunks, simplify) != tokenize(QList<QByteArray>() << input, simplify))
+	{
+		abort();
+	}
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "JournalTest.h"
+
+//Internal
+#include "../src/LogJournal.h"
+
+//Qt
+#include <QCoreApplication>
+#include <QFile>
+#include <QDir>
+#include <QtTest>
+
+//Const
+static const quint32 ORPHAN_PID_1 = 4000001;
+static const quint32 ORPHAN_PID_2 = 4000002;
+
+/*
+ * Each test function starts with a fresh log file
+ */
+void CJournalTest::init(void)
+{
+	m_logFileName = QDir(QDir::tempPath()).absoluteFilePath(QString("LoggingUtil_JournalTest_%1.log").arg(QCoreApplication::applicationPid()));
+	cleanup();
+}
+
+/*
+ * Remove the log file and all journals
+ */
+void CJournalTest::cleanup(void)
+{
+	QFile::remove(m_logFileName);
+	QFile::remove(QString("%1.%2.jnl").arg(m_logFileName, QString::number(ORPHAN_PID_1)));
+	QFile::remove(QString("%1.%2.jnl").arg(m_logFileName, QString::number(ORPHAN_PID_2)));
+	QFile::remove(CLogJournal::journalFileName(m_logFileName));
+}
+
+/*
+ * Two sessions appended to the same log and crashed: the first one after writing part of its pending data,
+ * the second one without writing any. The second journal's offset lies within the data of the first one.
+ */
+void CJournalTest::twoOrphanedSessions(void)
+{
+	writeLog("header\nA1\n");
+	createOrphan(ORPHAN_PID_1, 7, "A1\nA2\n");
+	createOrphan(ORPHAN_PID_2, 10, "B1\n");
+
+	qint64 recoveredBytes = 0, appendedBytes = 0;
+	QVERIFY(CLogJournal::recover(m_logFileName, recoveredBytes, appendedBytes));
+	QCOMPARE(readLog(), QByteArray("header\nA1\nA2\nB1\n"));
+	QCOMPARE(recoveredBytes, qint64(6));
+	QCOMPARE(appendedBytes, qint64(3));
+
+	//All journals are gone, so the next session does not fail to start
+	QVERIFY(!CLogJournal::exists(m_logFileName));
+	QVERIFY(CLogJournal::recover(m_logFileName, recoveredBytes, appendedBytes));
+	QCOMPARE(readLog(), QByteArray("header\nA1\nA2\nB1\n"));
+}
+
+/*
+ * Another session wrote beyond the journaled range, nothing must be overwritten or cut off
+ */
+void CJournalTest::logWrittenAfterCrash(void)
+{
+	writeLog("header\nA1\nC1\nC2\nC3\n");
+	createOrphan(ORPHAN_PID_1, 7, "A1\nA2\n");
+
+	qint64 recoveredBytes = 0, appendedBytes = 0;
+	QVERIFY(CLogJournal::recover(m_logFileName, recoveredBytes, appendedBytes));
+	QCOMPARE(readLog(), QByteArray("header\nA1\nC1\nC2\nC3\nA1\nA2\n"));
+	QCOMPARE(appendedBytes, qint64(6));
+	QVERIFY(!CLogJournal::exists(m_logFileName));
+}
+
+/*
+ * Leave a journal behind, as a crashed process with the given id would
+ */
+void CJournalTest::createOrphan(const quint32 pid, const qint64 fileOffset, const QByteArray &data)
+{
+	{
+		CLogJournal journal(m_logFileName);
+		QVERIFY(journal.open(fileOffset));
+		QVERIFY(journal.append(data.constData(), data.size()));
+	}
+
+	QVERIFY(QFile::rename(CLogJournal::journalFileName(m_logFileName), QString("%1.%2.jnl").arg(m_logFileName, QString::number(pid))));
+}
+
+/*
+ * Write the log file as it was left by the crashed sessions
+ */
+void CJournalTest::writeLog(const QByteArray &data)
+{
+	QFile logFile(m_logFileName);
+	QVERIFY(logFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+	QCOMPARE(logFile.write(data), qint64(data.size()));
+}
+
+/*
+ * Current content of the log file
+ */
+QByteArray CJournalTest::readLog(void)
+{
+	QFile logFile(m_logFileName);
+	return logFile.open(QIODevice::ReadOnly) ? logFile.readAll() : QByteArray();
+}
@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+//Class CJournalTest
+//Recovery of journals that have been left over by crashed sessions
+class CJournalTest : public QObject
+{
+	Q_OBJECT;
+
+private slots:
+	void init(void);
+	void cleanup(void);
+	void twoOrphanedSessions(void);
+	void logWrittenAfterCrash(void);
+
+private:
+	void createOrphan(const quint32 pid, const qint64 fileOffset, const QByteArray &data);
+	void writeLog(const QByteArray &data);
+	QByteArray readLog(void);
+
+	QString m_logFileName;
+};
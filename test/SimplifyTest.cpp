@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "SimplifyTest.h"
+
+//Internal
+#include "../src/LogFormatter.h"
+
+//Qt
+#include <QVector>
+#include <QtTest>
+
+//CRT
+#include <cstring>
+
+//Const
+static const int MAX_OFFSET = 8;
+static const ushort ALPHABET_ASCII[] = { 'a', 'b', 'Z', '0', ' ', ' ', '\t', '\n', '\v', '\f', '\r' };
+static const ushort ALPHABET_OTHER[] = { 0x00E9, 0x00A0, 0x0085, 0x2003, 0x3000, 0x4E2D, 0xD83D, 0xDE00 };
+
+//Helper
+#define ARRAY_SIZE(X) (sizeof(X) / sizeof((X)[0]))
+
+/*
+ * Fixed seed, so failures can be reproduced
+ */
+void CSimplifyTest::initTestCase(void)
+{
+	qsrand(0x5EED);
+}
+
+/*
+ * Every length up to a few vectors, this covers all tail sizes of the kernel
+ */
+void CSimplifyTest::allLengths(void)
+{
+	for(int len = 0; len <= 40; len++)
+	{
+		for(int round = 0; round < 64; round++)
+		{
+			check(randomText(len, false), 0);
+			if(QTest::currentTestFailed()) return;
+		}
+	}
+
+	//Whitespace only and no whitespace at all
+	for(int len = 0; len <= 40; len++)
+	{
+		check(QString(len, QChar(' ')), 0);
+		check(QString(len, QChar('\t')), 0);
+		check(QString(len, QChar('x')), 0);
+		if(QTest::currentTestFailed()) return;
+	}
+}
+
+/*
+ * The kernel uses unaligned loads and stores, start at every offset within a vector
+ */
+void CSimplifyTest::unalignedInput(void)
+{
+	for(int offset = 1; offset < MAX_OFFSET; offset++)
+	{
+		for(int len = 0; len <= 40; len++)
+		{
+			check(randomText(len, false), offset);
+			check(randomText(len, true), offset);
+			if(QTest::currentTestFailed()) return;
+		}
+	}
+}
+
+/*
+ * Long lines, whitespace runs cross the vector boundaries in every possible way
+ */
+void CSimplifyTest::longLines(void)
+{
+	for(int round = 0; round < 256; round++)
+	{
+		check(randomText(512 + (qrand() % 512), false), qrand() % MAX_OFFSET);
+		if(QTest::currentTestFailed()) return;
+	}
+}
+
+/*
+ * Non-ASCII units are passed to the scalar code by the kernel, including the Unicode spaces
+ */
+void CSimplifyTest::nonAscii(void)
+{
+	for(int round = 0; round < 256; round++)
+	{
+		check(randomText(qrand() % 256, true), qrand() % MAX_OFFSET);
+		if(QTest::currentTestFailed()) return;
+	}
+}
+
+/*
+ * Compare SIMD and scalar code with QString::simplified
+ */
+void CSimplifyTest::check(const QString &input, const int offset)
+{
+	const QString reference = input.simplified();
+	const int len = input.length();
+
+	QVector<QChar> bufferSIMD(len + MAX_OFFSET), bufferScalar(len + MAX_OFFSET);
+	memcpy(bufferSIMD.data() + offset, input.constData(), len * sizeof(QChar));
+	memcpy(bufferScalar.data() + offset, input.constData(), len * sizeof(QChar));
+
+	const int lenSIMD = CLogFormatter::simplify(bufferSIMD.data() + offset, len, true);
+	const int lenScalar = CLogFormatter::simplify(bufferScalar.data() + offset, len, false);
+
+	QCOMPARE(QString(bufferScalar.constData() + offset, lenScalar), reference);
+	QCOMPARE(QString(bufferSIMD.constData() + offset, lenSIMD), reference);
+}
+
+/*
+ * Random text, whitespace is much more frequent than in real logs
+ */
+QString CSimplifyTest::randomText(const int len, const bool nonAscii)
+{
+	QString text(len, QChar(' '));
+	for(int i = 0; i < len; i++)
+	{
+		if(nonAscii && ((qrand() % 4) == 0))
+		{
+			text[i] = QChar(ALPHABET_OTHER[qrand() % ARRAY_SIZE(ALPHABET_OTHER)]);
+			continue;
+		}
+		text[i] = QChar(ALPHABET_ASCII[qrand() % ARRAY_SIZE(ALPHABET_ASCII)]);
+	}
+	return text;
+}
@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QObject>
+
+//Class CSimplifyTest
+//Checks that the SIMD kernel of CLogFormatter::simplify gives the same result as the scalar code
+class CSimplifyTest : public QObject
+{
+	Q_OBJECT;
+
+private slots:
+	void initTestCase(void);
+	void allLengths(void);
+	void unalignedInput(void);
+	void longLines(void);
+	void nonAscii(void);
+
+private:
+	static void check(const QString &input, const int offset);
+	static QString randomText(const int len, const bool nonAscii);
+};
@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "StartupBenchmark.h"
+
+//Internal
+#include "../src/LogProcessor.h"
+
+//Win32
+#include <Windows.h>
+
+//Qt
+#include <QTemporaryFile>
+#include <QElapsedTimer>
+#include <QtTest>
+
+//CRT
+#include <cstring>
+
+//Const
+static const char *const TEST_LINE = "first line captured\n";
+static const qint64 STARTUP_BUDGET = 5; //milliseconds
+static const int BUDGET_RUNS = 25;
+
+/*
+ * Log a single line from a pipe, the cost of a short job that is dominated by startup
+ */
+void CStartupBenchmark::firstLine(void)
+{
+	QBENCHMARK
+	{
+		QVERIFY(runOnce());
+	}
+}
+
+/*
+ * The fastest of several runs must stay within the budget, so a busy machine does not make the check flaky
+ */
+void CStartupBenchmark::firstLineBudget(void)
+{
+	qint64 fastest = -1;
+
+	for(int i = 0; i < BUDGET_RUNS; i++)
+	{
+		QElapsedTimer timer;
+		timer.start();
+		QVERIFY(runOnce());
+		const qint64 elapsed = timer.elapsed();
+		fastest = (fastest < 0) ? elapsed : qMin(fastest, elapsed);
+	}
+
+	const QByteArray message = QString("Fastest run took %1 ms, budget is %2 ms").arg(QString::number(fastest), QString::number(STARTUP_BUDGET)).toLatin1();
+	QVERIFY2(fastest < STARTUP_BUDGET, message.constData());
+}
+
+/*
+ * Create a processor that reads a single line from a pipe, returns true if the line made it into the log
+ */
+bool CStartupBenchmark::runOnce(void)
+{
+	HANDLE readEnd = NULL, writeEnd = NULL;
+	if(!CreatePipe(&readEnd, &writeEnd, NULL, 0))
+	{
+		return false;
+	}
+
+	DWORD bytesWritten = 0;
+	const DWORD len = DWORD(strlen(TEST_LINE));
+	const bool written = WriteFile(writeEnd, TEST_LINE, len, &bytesWritten, NULL) && (bytesWritten == len);
+	CloseHandle(writeEnd);
+
+	QTemporaryFile logFile;
+	bool success = written && logFile.open();
+
+	if(success)
+	{
+		CLogProcessor processor(logFile, readEnd);
+		success = processor.startStdinProcessing();
+		if(success)
+		{
+			processor.exec();
+		}
+	}
+
+	CloseHandle(readEnd);
+
+	if(success)
+	{
+		logFile.flush();
+		logFile.seek(0);
+		success = logFile.readAll().contains("first line captured");
+	}
+
+	return success;
+}
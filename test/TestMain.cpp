@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+//Tests
+#include "SimplifyTest.h"
+#include "FormatBenchmark.h"
+#include "StartupBenchmark.h"
+#include "TokenizerTest.h"
+#include "JournalTest.h"
+
+//Qt
+#include <QCoreApplication>
+#include <QtTest>
+
+/*
+ * Run all test cases and benchmarks, the exit code is the number of failed test functions
+ */
+int main(int argc, char *argv[])
+{
+	QCoreApplication application(argc, argv);
+	int failures = 0;
+
+	CSimplifyTest simplifyTest;
+	failures += QTest::qExec(&simplifyTest, argc, argv);
+
+	CTokenizerTest tokenizerTest;
+	failures += QTest::qExec(&tokenizerTest, argc, argv);
+
+	CJournalTest journalTest;
+	failures += QTest::qExec(&journalTest, argc, argv);
+
+	CFormatBenchmark formatBenchmark;
+	failures += QTest::qExec(&formatBenchmark, argc, argv);
+
+	CStartupBenchmark startupBenchmark;
+	failures += QTest::qExec(&startupBenchmark, argc, argv);
+
+	return failures;
+}
@@ -0,0 +1,361 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "TokenizerTest.h"
+
+//Internal
+#include "../src/LogProcessor.h"
+#include "../src/BinaryFilter.h"
+
+//Qt
+#include <QTemporaryFile>
+#include <QStringList>
+#include <QtTest>
+
+//Const
+static const char *const ALPHABET_UTF8[] =
+{
+	"a", "b", "Z", "0", " ", " ", "\t", "\n", "\r\n", "\r", "\f", "\v", "\b",
+	"\xC3\xA9", "\xC2\xA0", "\xE4\xB8\xAD", "\xE2\x80\x83", "\xF0\x9F\x98\x80"
+};
+static const ushort ALPHABET_ESCAPE[] = { 'a', ' ', '<', '>', '&', '"', '\\', '\t', 0x01, 0x1F, 0x7F, 0x00E9, 0x4E2D };
+static const int MAX_CHUNK_SIZE = 64;
+static const int CONTROL_RATIO = 16;
+
+//Helper
+#define ARRAY_SIZE(X) (sizeof(X) / sizeof((X)[0]))
+
+//Forward declarations
+static QString unescapeHtml(const QString &text);
+static QString unescapeJson(const QString &text);
+
+/*
+ * Fixed seed, so failures can be reproduced
+ */
+void CTokenizerTest::initTestCase(void)
+{
+	qsrand(0x70CE);
+}
+
+/*
+ * Without simplification the bytes are tokenized without decoding
+ */
+void CTokenizerTest::passthroughSplits(void)
+{
+	for(int round = 0; round < 200; round++)
+	{
+		const QByteArray input = randomInput(qrand() % 512);
+		check(input, randomChunks(input), false);
+		if(QTest::currentTestFailed()) return;
+	}
+}
+
+/*
+ * With simplification the data is decoded first, the decoder must keep its state between the chunks
+ */
+void CTokenizerTest::decodeSplits(void)
+{
+	for(int round = 0; round < 200; round++)
+	{
+		const QByteArray input = randomInput(qrand() % 512);
+		check(input, randomChunks(input), true);
+		if(QTest::currentTestFailed()) return;
+	}
+}
+
+/*
+ * Split at every byte of a text with multibyte characters, including within the characters
+ */
+void CTokenizerTest::multibyteSplits(void)
+{
+	const QByteArray input("\xC3\xA9t\xC3\xA9\n\xE4\xB8\xAD\xE6\x96\x87 \xF0\x9F\x98\x80\r\n\xC2\xA0x\xC2\xA0\n\xF0\x9F\x98\x80");
+
+	for(int pos = 0; pos <= input.size(); pos++)
+	{
+		QList<QByteArray> chunks;
+		chunks << input.left(pos) << input.mid(pos);
+		check(input, chunks, false);
+		check(input, chunks, true);
+		if(QTest::currentTestFailed()) return;
+	}
+
+	//One byte at a time
+	QList<QByteArray> chunks;
+	for(int pos = 0; pos < input.size(); pos++)
+	{
+		chunks << input.mid(pos, 1);
+	}
+	check(input, chunks, false);
+	check(input, chunks, true);
+}
+
+/*
+ * A CR+LF pair that is split between two chunks must not give an extra (empty) line
+ */
+void CTokenizerTest::lineBreakSplits(void)
+{
+	const QByteArray input("first\r\nsecond\r\n\r\nthird\rfourth\n\nfifth");
+
+	for(int pos = 0; pos <= input.size(); pos++)
+	{
+		QList<QByteArray> chunks;
+		chunks << input.left(pos) << input.mid(pos);
+		check(input, chunks, false);
+		check(input, chunks, true);
+		if(QTest::currentTestFailed()) return;
+	}
+}
+
+/*
+ * The codec and the BOM are detected from the head of the stream, no matter how it is split
+ */
+void CTokenizerTest::headSplits(void)
+{
+	QList<QByteArray> inputs;
+	inputs << QByteArray("\xEF\xBB\xBF\xC3\xA9t\xC3\xA9\nsecond\n");
+	inputs << QByteArray("f\0i\0r\0s\0t\0\r\0\n\0s\0e\0c\0o\0n\0d\0\n\0", 28);
+	inputs << QByteArray("\xFF\xFE\n\0x\0", 6);
+
+	for(int i = 0; i < inputs.count(); i++)
+	{
+		const QByteArray &input = inputs.at(i);
+		for(int pos = 0; pos <= input.size(); pos++)
+		{
+			QList<QByteArray> chunks;
+			chunks << input.left(pos) << input.mid(pos);
+			QCOMPARE(tokenize(chunks, false), tokenize(QList<QByteArray>() << input, false));
+			QCOMPARE(tokenize(chunks, true), tokenize(QList<QByteArray>() << input, true));
+		}
+	}
+}
+
+/*
+ * The escaped text must decode back to the input
+ */
+void CTokenizerTest::escapeRoundTrip(void)
+{
+	for(int round = 0; round < 1000; round++)
+	{
+		QString text(qrand() % 64, QChar(' '));
+		for(int i = 0; i < text.length(); i++)
+		{
+			text[i] = QChar(ALPHABET_ESCAPE[qrand() % ARRAY_SIZE(ALPHABET_ESCAPE)]);
+		}
+
+		QString html, json;
+		CLogFormatter::escape(html, text.constData(), text.length());
+		CLogFormatter::escapeJson(json, text.constData(), text.length());
+
+		QCOMPARE(unescapeHtml(html), text);
+		QCOMPARE(unescapeJson(json), text);
+		QVERIFY(!html.contains(QChar('<')));
+		QVERIFY(!json.contains(QChar('\t')));
+	}
+}
+
+/*
+ * The SIMD byte classifier must agree with a simple count, for every length and alignment
+ */
+void CTokenizerTest::binaryDetection(void)
+{
+	static const char bytes[] = { 'a', ' ', '\n', '\t', '\x1B', '\x00', '\x01', '\x07', '\x1F', '\x7F', '\xFF' };
+
+	for(int len = 1; len <= 80; len++)
+	{
+		for(int round = 0; round < 64; round++)
+		{
+			const int offset = qrand() % 16;
+			QByteArray data(offset + len, 'a');
+			const int density = 1 + (qrand() % 32);
+			for(int i = offset; i < data.size(); i++)
+			{
+				if((qrand() % density) == 0) data[i] = bytes[qrand() % ARRAY_SIZE(bytes)];
+			}
+
+			int nulls = 0, controls = 0;
+			for(int i = offset; i < data.size(); i++)
+			{
+				const uchar c = uchar(data.at(i));
+				if(!c) nulls++;
+				if((c < 0x20) && ((c < 0x08) || (c > 0x0D)) && (c != 0x1B)) controls++;
+			}
+
+			const bool expected = (nulls > 0) || ((controls > 1) && ((controls * CONTROL_RATIO) >= len));
+			QCOMPARE(CBinaryFilter::isBinary(data.constData() + offset, len), expected);
+		}
+	}
+}
+
+/*
+ * Compare the lines for the given chunks with a single chunk and with the reference tokenizer
+ */
+void CTokenizerTest::check(const QByteArray &input, const QList<QByteArray> &chunks, const bool simplify)
+{
+	const QByteArray expected = reference(input, simplify);
+	QCOMPARE(tokenize(QList<QByteArray>() << input, simplify), expected);
+	QCOMPARE(tokenize(chunks, simplify), expected);
+}
+
+/*
+ * Feed the chunks to the processor (plain format, so the log contains nothing but the lines)
+ */
+QByteArray CTokenizerTest::tokenize(const QList<QByteArray> &chunks, const bool simplify)
+{
+	QTemporaryFile logFile;
+	if(!logFile.open())
+	{
+		return QByteArray("Failed to create log file!");
+	}
+
+	{
+		CLogProcessor processor(logFile);
+		processor.setOutputFormat(CLogFormatter::LOG_FORMAT_PLAIN);
+		processor.setSimplifyStrings(simplify);
+		processor.initializeLog();
+		for(int i = 0; i < chunks.count(); i++)
+		{
+			processor.processData(chunks.at(i), CHANNEL_STDOUT);
+		}
+		processor.flushBuffers();
+		processor.finishLog();
+	}
+
+	logFile.seek(0);
+	QByteArray output = logFile.readAll();
+	if(output.startsWith("\xEF\xBB\xBF"))
+	{
+		output.remove(0, 3);
+	}
+	return output;
+}
+
+/*
+ * Reference tokenizer, one line per line break (empty lines are not logged)
+ */
+QByteArray CTokenizerTest::reference(const QByteArray &input, const bool simplify)
+{
+	const QString text = QString::fromUtf8(input.constData(), input.size());
+	QString output, line;
+
+	for(int i = 0; i <= text.length(); i++)
+	{
+		if((i < text.length()) && (!CLogFormatter::isLineBreak(text.at(i).unicode())))
+		{
+			line.append(text.at(i));
+			continue;
+		}
+		if(simplify)
+		{
+			line = line.simplified();
+		}
+		if(!line.isEmpty())
+		{
+			output.append(line).append(QLatin1String("\r\n"));
+		}
+		line.clear();
+	}
+
+	return output.toUtf8();
+}
+
+/*
+ * Split at random positions, empty chunks included
+ */
+QList<QByteArray> CTokenizerTest::randomChunks(const QByteArray &input)
+{
+	QList<QByteArray> chunks;
+	int pos = 0;
+
+	while(pos < input.size())
+	{
+		const int len = qrand() % MAX_CHUNK_SIZE;
+		chunks << input.mid(pos, len);
+		pos += len;
+	}
+
+	return chunks;
+}
+
+/*
+ * Random UTF-8 text, line breaks and whitespace are much more frequent than in real logs
+ */
+QByteArray CTokenizerTest::randomInput(const int len)
+{
+	QByteArray input;
+	for(int i = 0; i < len; i++)
+	{
+		input.append(ALPHABET_UTF8[qrand() % ARRAY_SIZE(ALPHABET_UTF8)]);
+	}
+	return input;
+}
+
+// ===================================================
+// Misc Stuff
+// ===================================================
+
+/*
+ * Decoder for the HTML escapes
+ */
+static QString unescapeHtml(const QString &text)
+{
+	QString result(text);
+	result.replace(QLatin1String("&nbsp;"), QLatin1String(" "));
+	result.replace(QLatin1String("&quot;"), QLatin1String("\""));
+	result.replace(QLatin1String("&lt;"), QLatin1String("<"));
+	result.replace(QLatin1String("&gt;"), QLatin1String(">"));
+	result.replace(QLatin1String("&amp;"), QLatin1String("&"));
+	return result;
+}
+
+/*
+ * Decoder for the JSON escapes
+ */
+static QString unescapeJson(const QString &text)
+{
+	QString result;
+
+	for(int i = 0; i < text.length(); i++)
+	{
+		if((text.at(i) != QChar('\\')) || (i + 1 >= text.length()))
+		{
+			result.append(text.at(i));
+			continue;
+		}
+
+		const QChar c = text.at(++i);
+		if(c == QChar('t'))
+		{
+			result.append(QChar('\t'));
+		}
+		else if((c == QChar('u')) && (i + 4 < text.length()))
+		{
+			result.append(QChar(text.mid(i + 1, 4).toUShort(NULL, 16)));
+			i += 4;
+		}
+		else
+		{
+			result.append(c);
+		}
+	}
+
+	return result;
+}
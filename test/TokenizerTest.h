@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////////////
+// Logging Utility
+// Copyright (C) 2010-2013 LoRd_MuldeR <MuldeR2@GMX.de>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// http://www.gnu.org/licenses/gpl-2.0.txt
+///////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <QObject>
+#include <QList>
+#include <QByteArray>
+
+//Class CTokenizerTest
+//Checks that the tokenizer gives the same lines, however the input is split into chunks, and that the escapers round-trip
+class CTokenizerTest : public QObject
+{
+	Q_OBJECT;
+
+private slots:
+	void initTestCase(void);
+	void passthroughSplits(void);
+	void decodeSplits(void);
+	void multibyteSplits(void);
+	void lineBreakSplits(void);
+	void headSplits(void);
+	void escapeRoundTrip(void);
+	void binaryDetection(void);
+
+private:
+	static void check(const QByteArray &input, const QList<QByteArray> &chunks, const bool simplify);
+	static QByteArray tokenize(const QList<QByteArray> &chunks, const bool simplify);
+	static QByteArray reference(const QByteArray &input, const bool simplify);
+	static QList<QByteArray> randomChunks(const QByteArray &input);
+	static QByteArray randomInput(const int len);
+};